@@ -0,0 +1,515 @@
+#ifndef DISKHASHTABLE_H
+#define DISKHASHTABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "HashTable.h"
+
+using namespace std;
+
+// Extendible hashing on disk, for key sets larger than memory. Entries live
+// in fixed-size bucket pages of a local file; an in-memory directory of
+// 2^globalDepth page numbers maps the low bits of a key's primary hash to
+// its page, so a lookup reads at most one page - none if the page is in the
+// buffer pool. A full page is split in two by one more hash bit, moving
+// about half of its entries: growth costs one page, never the whole table.
+// The directory doubles (in memory only) when the splitting page already
+// uses every directory bit.
+//
+// File layout, DISK_PAGE_SIZE bytes per page:
+//   page 0           DiskTableHeader
+//   pages 1..n-1     DiskPageHeader, then records packed one after another:
+//                    primary, aux (uint32), key length (uint32), key bytes,
+//                    value
+// Each page records which hash bits it owns, so opening a file rebuilds the
+// directory from the page headers. Nothing is written ahead: the file is
+// only consistent after flush() or the destructor.
+
+const int DISK_PAGE_SIZE = 4096;
+// Pages the buffer pool holds unless told otherwise (4 MB)
+const int DISK_POOL_PAGES = 1024;
+const char DISK_TABLE_MAGIC[8] = {'H', 'T', 'D', 'I', 'S', 'K', '0', '1'};
+const uint32_t DISK_TABLE_VERSION = 1;
+// Directory of at most 2^30 pages (4 GB of directory, 4 TB of pages)
+const int DISK_MAX_GLOBAL_DEPTH = 30;
+
+enum DiskTableMode { DISK_CREATE, DISK_OPEN };
+
+struct DiskTableHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pageSize;
+    int32_t hashFunctionType;
+    uint32_t keySize;   // sizeof(K), 0 for string keys
+    uint32_t valueSize; // sizeof(V)
+    uint32_t globalDepth;
+    uint64_t pageCount; // Including this one
+    uint64_t elements;
+};
+
+struct DiskPageHeader {
+    uint32_t localDepth; // Hash bits shared by every key of the page
+    uint32_t pattern;    // Their value
+    uint32_t count;      // Records
+    uint32_t used;       // Bytes of records after the header
+};
+
+const int DISK_PAGE_CAPACITY = DISK_PAGE_SIZE - sizeof(DiskPageHeader);
+
+// Fixed number of page frames over a file, replaced in CLOCK order (a frame
+// used since the hand last passed gets a second chance). Dirty pages are
+// written back when evicted and on flush(). Frames can be pinned while a
+// caller works on more than one page at a time.
+class BufferPool {
+  private:
+    int fd;
+    int frames;
+    unique_ptr<char[]> memory;
+    vector<long long> framePage; // -1: free
+    vector<bool> dirty;
+    vector<bool> referenced;
+    vector<int> pins;
+    vector<int> pageFrame; // Frame of each page of the file, -1 if none
+    int hand;
+
+    long long reads;
+    long long writes;
+    long long hits;
+
+    char *frameData(int f) {
+        return memory.get() + (size_t)f * DISK_PAGE_SIZE;
+    }
+
+    void writeFrame(int f) {
+        ssize_t n = pwrite(fd, frameData(f), DISK_PAGE_SIZE,
+                           (off_t)framePage[f] * DISK_PAGE_SIZE);
+        if (n != DISK_PAGE_SIZE)
+            throw runtime_error("disktable: write failed");
+        writes++;
+        dirty[f] = false;
+    }
+
+    // Frees a frame, writing its page back if needed
+    int evict() {
+        for (int sweep = 0; sweep < 2 * frames + 1; sweep++) {
+            int f = hand;
+            hand = (hand + 1 == frames) ? 0 : hand + 1;
+            if (pins[f] > 0)
+                continue;
+            if (framePage[f] >= 0 && referenced[f]) {
+                referenced[f] = false;
+                continue;
+            }
+            if (framePage[f] >= 0) {
+                if (dirty[f])
+                    writeFrame(f);
+                pageFrame[framePage[f]] = -1;
+                framePage[f] = -1;
+            }
+            return f;
+        }
+        throw logic_error("disktable: every buffer pool frame is pinned");
+    }
+
+    int frameFor(long long page) {
+        if (page >= (long long)pageFrame.size())
+            pageFrame.resize(page + 1, -1);
+        int f = evict();
+        framePage[f] = page;
+        pageFrame[page] = f;
+        referenced[f] = true;
+        dirty[f] = false;
+        return f;
+    }
+
+  public:
+    BufferPool(int file, int numFrames)
+        : fd(file), frames(numFrames),
+          memory(new char[(size_t)numFrames * DISK_PAGE_SIZE]),
+          framePage(numFrames, -1), dirty(numFrames, false),
+          referenced(numFrames, false), pins(numFrames, 0), hand(0),
+          reads(0), writes(0), hits(0) {}
+
+    // Page contents, read from the file unless cached. Valid until the
+    // next fetch() / create() unless pinned.
+    char *fetch(long long page) {
+        if (page < (long long)pageFrame.size() && pageFrame[page] != -1) {
+            int f = pageFrame[page];
+            referenced[f] = true;
+            hits++;
+            return frameData(f);
+        }
+        int f = frameFor(page);
+        ssize_t n = pread(fd, frameData(f), DISK_PAGE_SIZE,
+                          (off_t)page * DISK_PAGE_SIZE);
+        if (n != DISK_PAGE_SIZE) {
+            pageFrame[page] = -1;
+            framePage[f] = -1;
+            throw runtime_error("disktable: read failed");
+        }
+        reads++;
+        return frameData(f);
+    }
+
+    // A page past the end of the file: zeroed, dirty, never read
+    char *create(long long page) {
+        int f = frameFor(page);
+        memset(frameData(f), 0, DISK_PAGE_SIZE);
+        dirty[f] = true;
+        return frameData(f);
+    }
+
+    void markDirty(long long page) { dirty[pageFrame[page]] = true; }
+
+    void pin(long long page) { pins[pageFrame[page]]++; }
+
+    void unpin(long long page) { pins[pageFrame[page]]--; }
+
+    void flush() {
+        for (int f = 0; f < frames; f++)
+            if (framePage[f] >= 0 && dirty[f])
+                writeFrame(f);
+    }
+
+    long long getReads() const { return reads; }
+    long long getWrites() const { return writes; }
+    long long getHits() const { return hits; }
+
+    void resetStatistics() { reads = writes = hits = 0; }
+};
+
+// Same insert / search / remove API as HashTable. Keys are strings or
+// trivially copyable types (stored as their bytes, see snapshotKeyBytes);
+// values must be trivially copyable. A record must fit in a page.
+template <typename K, typename V, typename Hash = KeyHash<K>>
+class DiskHashTable {
+  private:
+    int fd;
+    int hashFunctionType;
+    Hash hasher;
+    unique_ptr<BufferPool> pool;
+    vector<uint32_t> directory; // Page of each value of the low hash bits
+    int globalDepth;
+    long long pageCount;
+    long long numElements;
+    long long splits;
+
+    static_assert(is_trivially_copyable<V>::value,
+                  "disk table values must be trivially copyable");
+
+    [[noreturn]] static void fail(const string &what) {
+        throw runtime_error("disktable: " + what);
+    }
+
+    static DiskPageHeader &pageHeader(char *page) {
+        return *(DiskPageHeader *)page;
+    }
+
+    static int recordSize(size_t keyLength) {
+        return 3 * sizeof(uint32_t) + keyLength + sizeof(V);
+    }
+
+    static uint32_t readWord(const char *p) {
+        uint32_t w;
+        memcpy(&w, p, sizeof(w));
+        return w;
+    }
+
+    static int recordSizeAt(const char *record) {
+        return recordSize(readWord(record + 2 * sizeof(uint32_t)));
+    }
+
+    // Offset of the record for key in page, or -1
+    static int findRecord(char *page, const HashPair &h,
+                          string_view bytes) {
+        DiskPageHeader &ph = pageHeader(page);
+        const char *records = page + sizeof(DiskPageHeader);
+        for (uint32_t offset = 0; offset < ph.used;) {
+            const char *r = records + offset;
+            uint32_t length = readWord(r + 2 * sizeof(uint32_t));
+            if (readWord(r) == h.primary &&
+                readWord(r + sizeof(uint32_t)) == h.aux &&
+                length == bytes.size() &&
+                memcmp(r + 3 * sizeof(uint32_t), bytes.data(), length) == 0)
+                return offset;
+            offset += recordSize(length);
+        }
+        return -1;
+    }
+
+    static void appendRecord(char *page, const HashPair &h,
+                             string_view bytes, const V &value) {
+        DiskPageHeader &ph = pageHeader(page);
+        char *r = page + sizeof(DiskPageHeader) + ph.used;
+        uint32_t words[3] = {h.primary, h.aux, (uint32_t)bytes.size()};
+        memcpy(r, words, sizeof(words));
+        memcpy(r + sizeof(words), bytes.data(), bytes.size());
+        memcpy(r + sizeof(words) + bytes.size(), &value, sizeof(V));
+        ph.count++;
+        ph.used += recordSize(bytes.size());
+    }
+
+    // Records are packed, so values are not aligned
+    static const char *valueAt(const char *page, int offset) {
+        const char *r = page + sizeof(DiskPageHeader) + offset;
+        return r + 3 * sizeof(uint32_t) + readWord(r + 2 * sizeof(uint32_t));
+    }
+
+    uint32_t directoryIndex(const HashPair &h) const {
+        return h.primary & ((1u << globalDepth) - 1);
+    }
+
+    // Whether splits can ever separate the records of page from a key with
+    // primary hash primary: some bit from localDepth up to the deepest
+    // directory bit must differ. Otherwise keys whose hashes collide there
+    // would double the directory all the way to its limit first.
+    static bool separable(char *page, uint32_t primary) {
+        DiskPageHeader &ph = pageHeader(page);
+        uint32_t mask = ((1u << DISK_MAX_GLOBAL_DEPTH) - 1) &
+                        ~((1u << ph.localDepth) - 1);
+        const char *records = page + sizeof(DiskPageHeader);
+        for (uint32_t offset = 0; offset < ph.used;
+             offset += recordSizeAt(records + offset))
+            if ((readWord(records + offset) ^ primary) & mask)
+                return true;
+        return false;
+    }
+
+    // Splits a full page by hash bit localDepth: records with the bit set
+    // move to a new page, the rest are compacted in place, and the
+    // directory entries of the new half are pointed at the new page.
+    void split(uint32_t pageId) {
+        char *page = pool->fetch(pageId);
+        DiskPageHeader &ph = pageHeader(page);
+        int depth = ph.localDepth;
+        if (depth == globalDepth) {
+            if (globalDepth == DISK_MAX_GLOBAL_DEPTH)
+                fail("directory is full");
+            // Both halves of the doubled directory point where they did
+            size_t n = directory.size();
+            directory.resize(2 * n);
+            copy_n(directory.begin(), n, directory.begin() + n);
+            globalDepth++;
+        }
+
+        pool->pin(pageId);
+        uint32_t newId = (uint32_t)pageCount++;
+        char *target = pool->create(newId);
+        DiskPageHeader &th = pageHeader(target);
+        th.localDepth = depth + 1;
+        th.pattern = ph.pattern | (1u << depth);
+
+        char *records = page + sizeof(DiskPageHeader);
+        uint32_t kept = 0, count = 0;
+        for (uint32_t offset = 0; offset < ph.used;) {
+            char *r = records + offset;
+            int size = recordSizeAt(r);
+            if ((readWord(r) >> depth) & 1) {
+                memcpy(target + sizeof(DiskPageHeader) + th.used, r, size);
+                th.used += size;
+                th.count++;
+            } else {
+                memmove(records + kept, r, size);
+                kept += size;
+                count++;
+            }
+            offset += size;
+        }
+        ph.localDepth = depth + 1;
+        ph.used = kept;
+        ph.count = count;
+        pool->markDirty(pageId);
+        pool->unpin(pageId);
+
+        for (uint32_t i = th.pattern; i < directory.size();
+             i += 1u << (depth + 1))
+            directory[i] = newId;
+        splits++;
+    }
+
+    void writeHeader() {
+        DiskTableHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, DISK_TABLE_MAGIC, sizeof(DISK_TABLE_MAGIC));
+        h.version = DISK_TABLE_VERSION;
+        h.pageSize = DISK_PAGE_SIZE;
+        h.hashFunctionType = hashFunctionType;
+        h.keySize = SnapshotKeyCodec<K>::SIZE;
+        h.valueSize = sizeof(V);
+        h.globalDepth = globalDepth;
+        h.pageCount = pageCount;
+        h.elements = numElements;
+        char page[DISK_PAGE_SIZE] = {};
+        memcpy(page, &h, sizeof(h));
+        if (pwrite(fd, page, DISK_PAGE_SIZE, 0) != DISK_PAGE_SIZE)
+            fail("write failed");
+    }
+
+    void createFile() {
+        globalDepth = 0;
+        pageCount = 2;
+        directory.assign(1, 1);
+        pool->create(1); // Depth 0: owns every hash
+        writeHeader();
+    }
+
+    // Reads the header and rebuilds the directory from the page headers
+    void openFile() {
+        DiskTableHeader h;
+        if (pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+            memcmp(h.magic, DISK_TABLE_MAGIC, sizeof(DISK_TABLE_MAGIC)) != 0)
+            fail("not a disk table file");
+        if (h.version != DISK_TABLE_VERSION || h.pageSize != DISK_PAGE_SIZE)
+            fail("unsupported version or page size");
+        if (h.hashFunctionType != hashFunctionType)
+            fail("created with another hash function type");
+        if (h.keySize != SnapshotKeyCodec<K>::SIZE || h.valueSize != sizeof(V))
+            fail("created with other key or value types");
+        if (h.globalDepth > DISK_MAX_GLOBAL_DEPTH || h.pageCount < 2)
+            fail("corrupt header");
+
+        globalDepth = h.globalDepth;
+        pageCount = h.pageCount;
+        numElements = h.elements;
+        directory.assign((size_t)1 << globalDepth, 0);
+        for (long long p = 1; p < pageCount; p++) {
+            DiskPageHeader ph;
+            if (pread(fd, &ph, sizeof(ph), (off_t)p * DISK_PAGE_SIZE) !=
+                    (ssize_t)sizeof(ph) ||
+                ph.localDepth > (uint32_t)globalDepth ||
+                (ph.pattern >> ph.localDepth) != 0)
+                fail("corrupt page header");
+            for (uint64_t i = ph.pattern; i < directory.size();
+                 i += (uint64_t)1 << ph.localDepth)
+                directory[i] = (uint32_t)p;
+        }
+        for (uint32_t page : directory)
+            if (page == 0)
+                fail("directory has holes");
+    }
+
+  public:
+    DiskHashTable(const string &path, DiskTableMode mode,
+                  int poolPages = DISK_POOL_PAGES, int hashType = 1,
+                  const Hash &hash = Hash())
+        : fd(-1), hashFunctionType(hashType), hasher(hash), globalDepth(0),
+          pageCount(0), numElements(0), splits(0) {
+        if (poolPages < 2)
+            throw invalid_argument("DiskHashTable: need at least 2 pages");
+        int flags = O_RDWR;
+        if (mode == DISK_CREATE)
+            flags |= O_CREAT | O_TRUNC;
+        fd = open(path.c_str(), flags, 0644);
+        if (fd < 0)
+            fail("cannot open " + path);
+        pool.reset(new BufferPool(fd, poolPages));
+        try {
+            if (mode == DISK_CREATE)
+                createFile();
+            else
+                openFile();
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+
+    DiskHashTable(const DiskHashTable &) = delete;
+    DiskHashTable &operator=(const DiskHashTable &) = delete;
+
+    ~DiskHashTable() {
+        try {
+            flush();
+        } catch (...) {
+            // Nothing sensible to do in a destructor
+        }
+        close(fd);
+    }
+
+    bool insert(const K &key, const V &value) {
+        HashPair h = splitHashPair(hasher(key), hashFunctionType);
+        string_view bytes = snapshotKeyBytes(key);
+        int size = recordSize(bytes.size());
+        if (size > DISK_PAGE_CAPACITY)
+            throw length_error("DiskHashTable: key does not fit in a page");
+        for (;;) {
+            uint32_t pageId = directory[directoryIndex(h)];
+            char *page = pool->fetch(pageId);
+            if (findRecord(page, h, bytes) != -1)
+                return false;
+            if (pageHeader(page).used + size <= (uint32_t)DISK_PAGE_CAPACITY) {
+                appendRecord(page, h, bytes, value);
+                pool->markDirty(pageId);
+                numElements++;
+                return true;
+            }
+            if (!separable(page, h.primary))
+                fail("page full of keys whose hashes collide");
+            // The keys may all land on one side; split again if so
+            split(pageId);
+        }
+    }
+
+    bool search(const K &key, V &value) {
+        HashPair h = splitHashPair(hasher(key), hashFunctionType);
+        char *page = pool->fetch(directory[directoryIndex(h)]);
+        int offset = findRecord(page, h, snapshotKeyBytes(key));
+        if (offset == -1)
+            return false;
+        memcpy(&value, valueAt(page, offset), sizeof(V));
+        return true;
+    }
+
+    // Pages are not merged again; a page emptied by removals is reused by
+    // later inserts of its hash range
+    bool remove(const K &key) {
+        HashPair h = splitHashPair(hasher(key), hashFunctionType);
+        uint32_t pageId = directory[directoryIndex(h)];
+        char *page = pool->fetch(pageId);
+        int offset = findRecord(page, h, snapshotKeyBytes(key));
+        if (offset == -1)
+            return false;
+        DiskPageHeader &ph = pageHeader(page);
+        char *r = page + sizeof(DiskPageHeader) + offset;
+        int size = recordSizeAt(r);
+        memmove(r, r + size, ph.used - offset - size);
+        ph.used -= size;
+        ph.count--;
+        pool->markDirty(pageId);
+        numElements--;
+        return true;
+    }
+
+    // Writes every dirty page and the header
+    void flush() {
+        pool->flush();
+        writeHeader();
+    }
+
+    long long getSize() const { return numElements; }
+
+    long long getPageCount() const { return pageCount; }
+
+    int getGlobalDepth() const { return globalDepth; }
+
+    long long getSplits() const { return splits; }
+
+    // Buffer pool traffic since the last resetStatistics()
+    long long getPageReads() const { return pool->getReads(); }
+    long long getPageWrites() const { return pool->getWrites(); }
+    long long getPoolHits() const { return pool->getHits(); }
+
+    void resetStatistics() { pool->resetStatistics(); }
+};
+
+#endif // DISKHASHTABLE_H
@@ -0,0 +1,229 @@
+#ifndef FREQUENCYMAP_H
+#define FREQUENCYMAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "HashTable.h"
+#include "Workload.h"
+
+using namespace std;
+
+// Occurrence counts of the integers of an array, built in parallel, and
+// pair-difference queries over them. The keys are radix-partitioned on the
+// high bits of their hash into just enough partitions that each one's table
+// stays about cache-sized; every partition is then counted by one thread,
+// without locks.
+//
+// countPairs(k) is the number of pairs i < j with |a[i] - a[j]| == k, except
+// that pairs of equal values are counted twice for k == 0 (as the serial
+// countPairs in count-pair-diff.cpp does): sum f(v) * f(v + |k|) over the
+// distinct values v, or sum f(v) * (f(v) - 1) for k == 0. Many k are
+// answered by one pass over the distinct values.
+
+// Distinct keys a partition is sized for: a table of these at
+// FREQUENCY_MAX_LOAD fits in a typical L2 cache
+const int FREQUENCY_PARTITION_KEYS = 1 << 14;
+const int FREQUENCY_MAX_PARTITION_BITS = 12;
+const double FREQUENCY_MAX_LOAD = 0.7;
+// Keys per block when scattering in parallel
+const int FREQUENCY_BLOCK = 1 << 16;
+
+template <typename K, typename Hash = KeyHash<K>> class FrequencyMap {
+    static_assert(is_integral<K>::value, "FrequencyMap: integer keys only");
+
+  private:
+    // Linear probing; a zero count marks an empty slot
+    struct Partition {
+        vector<K> keys;
+        vector<uint64_t> counts;
+        uint64_t distinct = 0;
+
+        Partition() : keys(16), counts(16, 0) {}
+
+        size_t findSlot(K key, uint64_t hash) const {
+            size_t mask = keys.size() - 1;
+            size_t slot = hash & mask;
+            while (counts[slot] != 0 && keys[slot] != key)
+                slot = (slot + 1) & mask;
+            return slot;
+        }
+
+        void add(K key, uint64_t hash, const Hash &hasher) {
+            if (distinct + 1 > FREQUENCY_MAX_LOAD * keys.size())
+                grow(hasher);
+            size_t slot = findSlot(key, hash);
+            if (counts[slot] == 0) {
+                keys[slot] = key;
+                distinct++;
+            }
+            counts[slot]++;
+        }
+
+        void grow(const Hash &hasher) {
+            vector<K> oldKeys(2 * keys.size());
+            vector<uint64_t> oldCounts(2 * counts.size(), 0);
+            keys.swap(oldKeys);
+            counts.swap(oldCounts);
+            for (size_t i = 0; i < oldKeys.size(); i++) {
+                if (oldCounts[i] == 0)
+                    continue;
+                size_t slot = findSlot(oldKeys[i], hasher(oldKeys[i]));
+                keys[slot] = oldKeys[i];
+                counts[slot] = oldCounts[i];
+            }
+        }
+
+        uint64_t count(K key, uint64_t hash) const {
+            return counts[findSlot(key, hash)];
+        }
+    };
+
+    vector<Partition> partitions;
+    int partitionBits;
+    int threads;
+    Hash hasher;
+    uint64_t total;
+
+    // Distance of key above the smallest K, so that differences of any
+    // two keys, and whether key + d is still a K, are unsigned arithmetic
+    static uint64_t offsetOf(K key) {
+        return (uint64_t)key - (uint64_t)numeric_limits<K>::min();
+    }
+
+    static K keyAt(uint64_t offset) {
+        return (K)(offset + (uint64_t)numeric_limits<K>::min());
+    }
+
+    int partitionOf(uint64_t hash) const {
+        return partitionBits == 0 ? 0 : hash >> (64 - partitionBits);
+    }
+
+    // Scatters keys by partition (per block counts, then each block writes
+    // its own range of every partition) and counts every partition on one
+    // thread
+    void build(const K *keys, size_t n) {
+        int parts = partitions.size();
+        if (threads == 1 || n < (size_t)FREQUENCY_BLOCK) {
+            for (size_t i = 0; i < n; i++) {
+                uint64_t h = hasher(keys[i]);
+                partitions[partitionOf(h)].add(keys[i], h, hasher);
+            }
+            return;
+        }
+
+        uint64_t blocks = (n + FREQUENCY_BLOCK - 1) / FREQUENCY_BLOCK;
+        vector<uint64_t> start(blocks * parts, 0);
+        parallelFor(blocks, threads, [&](uint64_t b) {
+            size_t end = min(n, (size_t)(b + 1) * FREQUENCY_BLOCK);
+            for (size_t i = b * FREQUENCY_BLOCK; i < end; i++)
+                start[b * parts + partitionOf(hasher(keys[i]))]++;
+        });
+        vector<uint64_t> partitionStart(parts + 1, 0);
+        uint64_t running = 0;
+        for (int p = 0; p < parts; p++) {
+            partitionStart[p] = running;
+            for (uint64_t b = 0; b < blocks; b++) {
+                uint64_t c = start[b * parts + p];
+                start[b * parts + p] = running;
+                running += c;
+            }
+        }
+        partitionStart[parts] = running;
+        vector<K> staged(n);
+        parallelFor(blocks, threads, [&](uint64_t b) {
+            size_t end = min(n, (size_t)(b + 1) * FREQUENCY_BLOCK);
+            for (size_t i = b * FREQUENCY_BLOCK; i < end; i++) {
+                int p = partitionOf(hasher(keys[i]));
+                staged[start[b * parts + p]++] = keys[i];
+            }
+        });
+
+        parallelFor(parts, threads, [&](uint64_t p) {
+            for (uint64_t i = partitionStart[p]; i < partitionStart[p + 1];
+                 i++)
+                partitions[p].add(staged[i], hasher(staged[i]), hasher);
+        });
+    }
+
+  public:
+    FrequencyMap(const K *keys, size_t n, int threadCount = 0,
+                 const Hash &hash = Hash())
+        : partitionBits(0), threads(workloadThreads(threadCount)),
+          hasher(hash), total(n) {
+        while (partitionBits < FREQUENCY_MAX_PARTITION_BITS &&
+               (n >> partitionBits) > (size_t)FREQUENCY_PARTITION_KEYS)
+            partitionBits++;
+        partitions.resize((size_t)1 << partitionBits);
+        build(keys, n);
+    }
+
+    explicit FrequencyMap(const vector<K> &keys, int threadCount = 0)
+        : FrequencyMap(keys.data(), keys.size(), threadCount) {}
+
+    // Occurrences of key
+    uint64_t count(K key) const {
+        uint64_t h = hasher(key);
+        return partitions[partitionOf(h)].count(key, h);
+    }
+
+    uint64_t distinct() const {
+        uint64_t d = 0;
+        for (const Partition &p : partitions)
+            d += p.distinct;
+        return d;
+    }
+
+    uint64_t size() const { return total; }
+
+    int partitionCount() const { return partitions.size(); }
+
+    // countPairs for every k of diffs, from one pass over the distinct
+    // values: each partition on one thread, looking up v + |k| wherever
+    // that lives (the tables are only read now)
+    vector<uint64_t> countPairs(const vector<long long> &diffs) const {
+        int parts = partitions.size();
+        size_t q = diffs.size();
+        vector<uint64_t> perPartition(parts * q, 0);
+        // |k| without overflow, for LLONG_MIN too
+        vector<uint64_t> distances(q);
+        for (size_t j = 0; j < q; j++)
+            distances[j] = diffs[j] < 0 ? 0 - (uint64_t)diffs[j]
+                                        : (uint64_t)diffs[j];
+        const uint64_t highest = offsetOf(numeric_limits<K>::max());
+        parallelFor(parts, threads, [&](uint64_t p) {
+            const Partition &part = partitions[p];
+            uint64_t *result = &perPartition[p * q];
+            for (size_t i = 0; i < part.keys.size(); i++) {
+                uint64_t f = part.counts[i];
+                if (f == 0)
+                    continue;
+                uint64_t offset = offsetOf(part.keys[i]);
+                for (size_t j = 0; j < q; j++) {
+                    uint64_t d = distances[j];
+                    if (d == 0) {
+                        result[j] += f * (f - 1);
+                        continue;
+                    }
+                    if (d > highest || offset > highest - d)
+                        continue;
+                    result[j] += f * count(keyAt(offset + d));
+                }
+            }
+        });
+        vector<uint64_t> results(q, 0);
+        for (int p = 0; p < parts; p++)
+            for (size_t j = 0; j < q; j++)
+                results[j] += perPartition[p * q + j];
+        return results;
+    }
+
+    uint64_t countPairs(long long k) const {
+        return countPairs(vector<long long>{k})[0];
+    }
+};
+
+#endif // FREQUENCYMAP_H
@@ -0,0 +1,176 @@
+#ifndef HASHFUNCTIONS_H
+#define HASHFUNCTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Word-at-a-time 64-bit hashing and division-free range reduction, shared by
+// the OnlineB and OnlineC tables.
+
+const uint64_t WY_SECRET[4] = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+                               0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+// 64x64 -> 128 bit multiply, folded back to 64 bits
+inline uint64_t wyMum(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+inline uint64_t wyRead8(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t wyRead4(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// 1..3 bytes, read without branching on the exact length
+inline uint64_t wyRead3(const uint8_t *p, size_t k) {
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+inline uint64_t wyHash(const void *key, size_t len, uint64_t seed = 0);
+
+// Long keys: eight 64-bit lanes fed one 64-byte stripe at a time, in the style
+// of XXH3's accumulator. With SSE2 two lanes are processed per instruction.
+inline uint64_t stripeHash(const uint8_t *p, size_t len, uint64_t seed) {
+    const uint64_t STRIPE_SECRET[8] = {
+        0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL,
+        0x1f67b3b7a4a44072ULL, 0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL,
+        0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL};
+    const size_t STRIPE = 64;
+    const size_t STRIPES_PER_SCRAMBLE = 16;
+    const uint64_t PRIME = 0x9E3779B1ULL;
+
+    alignas(16) uint64_t acc[8];
+    for (int i = 0; i < 8; i++)
+        acc[i] = WY_SECRET[i & 3] ^ (seed + i);
+
+    size_t stripes = len / STRIPE;
+    for (size_t s = 0; s < stripes; s++) {
+        const uint8_t *stripe = p + s * STRIPE;
+#ifdef __SSE2__
+        for (int i = 0; i < 8; i += 2) {
+            __m128i data = _mm_loadu_si128((const __m128i *)(stripe + 8 * i));
+            __m128i key = _mm_xor_si128(
+                data, _mm_loadu_si128((const __m128i *)&STRIPE_SECRET[i]));
+            // lo32(key) * hi32(key) for both lanes
+            __m128i product =
+                _mm_mul_epu32(key, _mm_shuffle_epi32(key, 0x31));
+            __m128i swapped = _mm_shuffle_epi32(data, 0x4E);
+            __m128i a = _mm_load_si128((const __m128i *)&acc[i]);
+            a = _mm_add_epi64(a, _mm_add_epi64(product, swapped));
+            _mm_store_si128((__m128i *)&acc[i], a);
+        }
+#else
+        for (int i = 0; i < 8; i++) {
+            uint64_t data = wyRead8(stripe + 8 * i);
+            uint64_t key = data ^ STRIPE_SECRET[i];
+            acc[i ^ 1] += data;
+            acc[i] += (key & 0xFFFFFFFFULL) * (key >> 32);
+        }
+#endif
+        if ((s + 1) % STRIPES_PER_SCRAMBLE == 0) {
+            for (int i = 0; i < 8; i++) {
+                acc[i] ^= (acc[i] >> 47) ^ STRIPE_SECRET[i];
+                acc[i] *= PRIME;
+            }
+        }
+    }
+
+    uint64_t h = len * 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 8; i += 2)
+        h += wyMum(acc[i] ^ WY_SECRET[1], acc[i + 1] ^ WY_SECRET[2]);
+
+    // Bytes after the last full stripe
+    size_t done = stripes * STRIPE;
+    return wyMum(h ^ WY_SECRET[0], wyHash(p + done, len - done, h));
+}
+
+// Keys at least this long go through stripeHash
+const size_t STRIPE_HASH_MIN_LENGTH = 256;
+
+// wyhash (final version 4 layout): keys up to 16 bytes are hashed from two
+// overlapping word reads and a single 128-bit multiply; longer keys 16 or 48
+// bytes per round.
+inline uint64_t wyHash(const void *key, size_t len, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *)key;
+    if (len >= STRIPE_HASH_MIN_LENGTH)
+        return stripeHash(p, len, seed);
+
+    const uint64_t *s = WY_SECRET;
+    seed ^= wyMum(seed ^ s[0], s[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wyRead4(p) << 32) | wyRead4(p + ((len >> 3) << 2));
+            b = (wyRead4(p + len - 4) << 32) |
+                wyRead4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = wyRead3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = wyMum(wyRead8(p) ^ s[1], wyRead8(p + 8) ^ seed);
+                see1 = wyMum(wyRead8(p + 16) ^ s[2], wyRead8(p + 24) ^ see1);
+                see2 = wyMum(wyRead8(p + 32) ^ s[3], wyRead8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wyMum(wyRead8(p) ^ s[1], wyRead8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyRead8(p + i - 16);
+        b = wyRead8(p + i - 8);
+    }
+    a ^= s[1];
+    b ^= seed;
+    __uint128_t r = (__uint128_t)a * b;
+    a = (uint64_t)r;
+    b = (uint64_t)(r >> 64);
+    return wyMum(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+// Maps a 32-bit hash to [0, d) without a division instruction. For a power of
+// two d this is a mask; otherwise Lemire's fastmod, which returns exactly
+// a % d using two multiplications with a precomputed 64-bit inverse.
+class RangeReducer {
+  private:
+    uint64_t inverse;
+    uint32_t divisor;
+    bool powerOfTwo;
+
+  public:
+    RangeReducer() : inverse(0), divisor(1), powerOfTwo(true) {}
+    explicit RangeReducer(uint32_t d)
+        : inverse(UINT64_C(0xFFFFFFFFFFFFFFFF) / d + 1), divisor(d),
+          powerOfTwo((d & (d - 1)) == 0) {}
+
+    uint32_t operator()(uint32_t a) const {
+        if (powerOfTwo)
+            return a & (divisor - 1);
+        uint64_t low = inverse * a;
+        return (uint32_t)(((__uint128_t)low * divisor) >> 64);
+    }
+};
+
+#endif // HASHFUNCTIONS_H
@@ -4,93 +4,626 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <new>
 #include <random>
-#include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#include "HashFunctions.h"
+#include "SnapshotFormat.h"
+#include "TableStats.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 // Configuration parameters
 const int INITIAL_TABLE_SIZE = 13;
+const int INITIAL_POWER_OF_TWO_SIZE = 16;
 const double LOAD_FACTOR_THRESHOLD = 0.5;
+// Group probing checks 16 slots per probe, so it can be filled much further
+const double GROUP_LOAD_FACTOR_THRESHOLD = 0.875;
+// Robin Hood keeps probe lengths short and their variance low even when the
+// table is nearly full
+const double ROBIN_HOOD_LOAD_FACTOR_THRESHOLD = 0.9;
+// Cuckoo lookups read two buckets at any load; insertion gets expensive
+// (and starts to fail) only very close to full
+const double CUCKOO_LOAD_FACTOR_THRESHOLD = 0.95;
 const double COMPACTION_THRESHOLD = 0.25;
+// Rebuild an open addressing table once this fraction of it is tombstones
+const double TOMBSTONE_THRESHOLD = 0.25;
+// Old-generation buckets moved per operation during an incremental resize, at
+// least; more if the next resize could otherwise come due first
+const int MIGRATION_BUCKETS_PER_OP = 4;
+// Keys hashed and prefetched together by insertBatch / searchBatch: enough
+// cache misses in flight to cover DRAM latency, few enough that the
+// prefetched lines are still in L1 when the keys are resolved
+const int BATCH_GROUP_SIZE = 16;
 // Constants for custom probing
 const int C1 = 1;
 const int C2 = 3;
+// An open addressing insert looks for a free slot among the first
+// INSERT_PROBE_FACTOR / (1 - max occupancy) probes, many times the expected
+// number; a longer sequence means clustering, and the table grows instead
+const int INSERT_PROBE_FACTOR = 16;
+// Cuckoo hashing: slots per bucket, buckets searched for a free slot before
+// an insert gives up on kicking entries out (about five displacements
+// deep), and keys that may then wait in the stash before the table grows;
+// at any load, an insert never adds to a stash of CUCKOO_STASH_LIMIT keys
+const int CUCKOO_BUCKET_SLOTS = 4;
+const int CUCKOO_BFS_NODES = 512;
+const int CUCKOO_STASH_SIZE = 4;
+const int CUCKOO_STASH_LIMIT = 64;
+// Alignment of data written by different threads (concurrent tables)
+const int CACHE_LINE_SIZE = 64;
 
 // Enum for collision resolution methods
-enum CollisionMethod { CHAINING, DOUBLE_HASHING, CUSTOM_PROBING };
+enum CollisionMethod {
+    CHAINING,
+    DOUBLE_HASHING,
+    CUSTOM_PROBING,
+    GROUP_PROBING, // Swiss table: control bytes scanned a group at a time
+    ROBIN_HOOD,    // Linear probing, entries ordered by distance from home
+    CUCKOO_HASHING // Two candidate buckets of CUCKOO_BUCKET_SLOTS per key
+};
+
+// Key stored inline in the slot instead of as a std::string: exactly N bytes,
+// shorter keys padded with '\0'. Equality is a memcmp of constant size, which
+// compiles to one or two word-sized loads for word-length keys.
+template <size_t N> struct FixedString {
+    char data[N];
+
+    FixedString() { memset(data, 0, N); }
+    FixedString(const string &s) {
+        if (s.size() > N)
+            throw length_error("FixedString: key longer than capacity");
+        memcpy(data, s.data(), s.size());
+        memset(data + s.size(), 0, N - s.size());
+    }
+
+    string str() const { return string(data, strnlen(data, N)); }
+
+    bool operator==(const FixedString &o) const {
+        return memcmp(data, o.data, N) == 0;
+    }
+};
+
+// The two string hashes, updated together one character at a time:
+//   hash1 = polynomial rolling hash (p = 31)
+//   hash2 = djb2
+struct RollingHashes {
+    unsigned long long hash1 = 0;
+    unsigned long long p_pow = 1;
+    unsigned long long hash2 = 5381;
+
+    void add(char c) {
+        hash1 += (c - 'a' + 1) * p_pow;
+        p_pow *= 31;
+        hash2 = ((hash2 << 5) + hash2) + c;
+    }
+
+    static uint32_t fold(unsigned long long h) {
+        return (uint32_t)(h ^ (h >> 32));
+    }
+
+    // hash1 in the upper, hash2 in the lower 32 bits
+    uint64_t result() const {
+        return ((uint64_t)fold(hash1) << 32) | fold(hash2);
+    }
+};
+
+// Default hash functor of HashTable. Returns two 32-bit hashes packed into one
+// value: hash1 in the upper and hash2 in the lower half.
+template <typename K, typename Enable = void> struct KeyHash;
+
+// Integers are hashed directly, never converted to strings: two
+// multiply-shift hashes with different odd multipliers, each taking the high
+// half of a 64-bit product.
+template <typename K>
+struct KeyHash<K, typename enable_if<is_integral<K>::value>::type> {
+    uint64_t operator()(K key) const {
+        uint64_t x = (uint64_t)key;
+        uint64_t hash1 = (x * 0x9E3779B97F4A7C15ULL) >> 32;
+        uint64_t hash2 = (x * 0xC2B2AE3D27D4EB4FULL) >> 32;
+        return (hash1 << 32) | hash2;
+    }
+};
+
+template <> struct KeyHash<string> {
+    uint64_t operator()(const string &key) const {
+        RollingHashes h;
+        for (char c : key)
+            h.add(c);
+        return h.result();
+    }
+};
+
+// Same hashes for views, e.g. tokens of a mapped input file (InputReader.h)
+template <> struct KeyHash<string_view> {
+    uint64_t operator()(string_view key) const {
+        RollingHashes h;
+        for (char c : key)
+            h.add(c);
+        return h.result();
+    }
+};
+
+// wyhash over the key bytes: word-at-a-time, and SIMD-accumulated for keys of
+// STRIPE_HASH_MIN_LENGTH bytes and more. Usable as the Hash parameter of
+// HashTable for string, string_view and FixedString keys.
+struct WyHash {
+    uint64_t operator()(const string &key) const {
+        return wyHash(key.data(), key.size());
+    }
+
+    uint64_t operator()(string_view key) const {
+        return wyHash(key.data(), key.size());
+    }
+
+    template <size_t N> uint64_t operator()(const FixedString<N> &key) const {
+        return wyHash(key.data, N);
+    }
+};
+
+template <size_t N> struct KeyHash<FixedString<N>> {
+    uint64_t operator()(const FixedString<N> &key) const {
+        // Constant trip count: fully unrolled, padding included
+        RollingHashes h;
+#pragma GCC unroll 32
+        for (size_t i = 0; i < N; i++)
+            h.add(key.data[i]);
+        return h.result();
+    }
+};
+
+// Primary and auxiliary hash of a key. Both are independent of the table
+// size, so they are computed once per operation and stored with the entry;
+// comparing them first filters out almost every non-matching key, and a
+// rehash only needs to reduce them to the new size.
+struct HashPair {
+    uint32_t primary;
+    uint32_t aux;
+    bool operator==(const HashPair &o) const {
+        return primary == o.primary && aux == o.aux;
+    }
+};
+
+// Hash type 1 probes with hash1 (upper half of the Hash result) and steps
+// with hash2; hash type 2 the other way round
+inline HashPair splitHashPair(uint64_t h, int hashFunctionType) {
+    uint32_t hash1 = (uint32_t)(h >> 32);
+    uint32_t hash2 = (uint32_t)h;
+    if (hashFunctionType == 1)
+        return {hash1, hash2};
+    return {hash2, hash1};
+}
+
+// Prime number utilities, shared by the tables of prime size
+inline bool isPrime(int n) {
+    if (n <= 1)
+        return false;
+    if (n <= 3)
+        return true;
+    if (n % 2 == 0 || n % 3 == 0)
+        return false;
+    for (int i = 5; i * i <= n; i += 6) {
+        if (n % i == 0 || n % (i + 2) == 0)
+            return false;
+    }
+    return true;
+}
+
+// Smallest prime above n
+inline int nextPrime(int n) {
+    if (n <= 2)
+        return 2;
+    int prime = (n % 2 == 0) ? n + 1 : n + 2;
+    while (!isPrime(prime))
+        prime += 2;
+    return prime;
+}
+
+// Table sizes: primes (indices by exact modulo, computed with fastmod) or
+// powers of two (indices by masking)
+enum SizePolicy { PRIME_SIZES, POWER_OF_TWO_SIZES };
 
 // Node structure for chaining
-template <typename V> struct ChainNode {
-    string key;
+template <typename K, typename V> struct ChainNode {
+    K key;
     V value;
+    HashPair hash;
     ChainNode *next;
-    ChainNode(const string &k, const V &v) : key(k), value(v), next(nullptr) {}
+    ChainNode(const K &k, const V &v, const HashPair &h)
+        : key(k), value(v), hash(h), next(nullptr) {}
+};
+
+// Slab allocator for chain nodes. Nodes are carved sequentially out of large
+// slabs, so nodes inserted one after another sit next to each other, and
+// released nodes go to a free list for reuse. Destroying the pool releases
+// whole slabs without visiting individual nodes.
+template <typename K, typename V> class ChainNodePool {
+  private:
+    static const int NODES_PER_SLAB = 4096;
+
+    vector<ChainNode<K, V> *> slabs; // The last one is the one being carved
+    int carved;                   // Nodes handed out from the last slab
+    ChainNode<K, V> *freeList;       // Released nodes, linked through next
+
+    ChainNode<K, V> *takeMemory() {
+        if (freeList != nullptr) {
+            ChainNode<K, V> *node = freeList;
+            freeList = node->next;
+            return node;
+        }
+        if (slabs.empty() || carved == NODES_PER_SLAB) {
+            slabs.push_back((ChainNode<K, V> *)::operator new(
+                NODES_PER_SLAB * sizeof(ChainNode<K, V>)));
+            carved = 0;
+        }
+        return slabs.back() + carved++;
+    }
+
+  public:
+    ChainNodePool() : carved(0), freeList(nullptr) {}
+    ChainNodePool(const ChainNodePool &) = delete;
+    ChainNodePool &operator=(const ChainNodePool &) = delete;
+
+    ~ChainNodePool() {
+        destroyLive();
+        for (ChainNode<K, V> *slab : slabs)
+            ::operator delete(slab);
+    }
+
+    ChainNode<K, V> *allocate(const K &key, const V &value,
+                           const HashPair &h) {
+        return new (takeMemory()) ChainNode<K, V>(key, value, h);
+    }
+
+    void release(ChainNode<K, V> *node) {
+        node->~ChainNode<K, V>();
+        node->next = freeList;
+        freeList = node;
+    }
+
+  private:
+    // Runs the destructor of every node still in use, walking the slabs in
+    // memory order instead of chasing chains. Skipped entirely when the
+    // nodes are trivially destructible.
+    void destroyLive() {
+        if (is_trivially_destructible<ChainNode<K, V>>::value)
+            return;
+        vector<ChainNode<K, V> *> released;
+        for (ChainNode<K, V> *node = freeList; node != nullptr; node = node->next)
+            released.push_back(node);
+        sort(released.begin(), released.end());
+
+        for (size_t s = 0; s < slabs.size(); s++) {
+            int used = (s + 1 == slabs.size()) ? carved : NODES_PER_SLAB;
+            for (int i = 0; i < used; i++) {
+                ChainNode<K, V> *node = slabs[s] + i;
+                if (released.empty() ||
+                    !binary_search(released.begin(), released.end(), node))
+                    node->~ChainNode<K, V>();
+            }
+        }
+    }
 };
 
 // Entry structure for open addressing
-template <typename V> struct Entry {
-    string key;
+template <typename K, typename V> struct Entry {
+    K key;
     V value;
+    HashPair hash;
     bool occupied;
     bool deleted;
-    Entry() : occupied(false), deleted(false) {}
-    Entry(const string &k, const V &v)
-        : key(k), value(v), occupied(true), deleted(false) {}
+    Entry() : hash{0, 0}, occupied(false), deleted(false) {}
+    Entry(const K &k, const V &v, const HashPair &h)
+        : key(k), value(v), hash(h), occupied(true), deleted(false) {}
 };
 
-// Hash Table Class
-template <typename V> class HashTable {
+// Probe sequence of one key in a table of size m, given the already reduced
+// Hash(k) and auxHash(k); next() only advances the index with additions.
+//   DOUBLE_HASHING: (Hash(k) + i * auxHash(k)) % N
+//   CUSTOM_PROBING: (Hash(k) + C1*i*auxHash(k) + C2*i^2) % N on primes,
+//                   (Hash(k) + s * i*(i+1)/2) % N with an odd
+//                   s = (C1*auxHash(k) + C2) | 1 on powers of two
+//   ROBIN_HOOD:     (Hash(k) + i) % N
+// Double hashing and the triangular sequence visit every slot within N
+// probes. The quadratic one on a prime N may reach only about half of them;
+// HashTable no longer builds such tables, but older snapshots use it.
+class ProbeSequence {
+  private:
+    long long m;
+    long long index;
+    long long step;     // Distance to the next index
+    long long stepGrow; // Change of step per probe (2*C2 for custom probing)
+
+  public:
+    ProbeSequence(long long home, long long aux, int size,
+                  CollisionMethod method)
+        : m(size), index(home) {
+        if (method == CUSTOM_PROBING && (m & (m - 1)) == 0) {
+            // T(i+1) - T(i) = i + 1, so the step grows by s per probe
+            step = ((C1 * aux + C2) & (m - 1)) | 1;
+            stepGrow = step;
+        } else if (method == CUSTOM_PROBING) {
+            // i^2 - (i-1)^2 = 2i - 1, so the step grows by 2*C2 per probe
+            step = ((C1 * aux + C2) % m + m) % m;
+            stepGrow = ((2LL * C2) % m + m) % m;
+        } else {
+            step = aux;
+            stepGrow = 0;
+        }
+    }
+
+    int next() {
+        int current = (int)index;
+        index += step;
+        if (index >= m)
+            index -= m;
+        step += stepGrow;
+        if (step >= m)
+            step -= m;
+        return current;
+    }
+};
+
+// Control bytes for GROUP_PROBING. A full slot stores the low 7 bits of its
+// aux hash, so the sign bit alone tells empty/deleted from full.
+const int GROUP_WIDTH = 16;
+const int8_t CTRL_EMPTY = -128;
+const int8_t CTRL_DELETED = -2;
+
+// GROUP_WIDTH consecutive control bytes, compared in one instruction with SSE2
+// and byte by byte otherwise. Each match returns a bit mask of slots.
+class CtrlGroup {
+  private:
+#ifdef __SSE2__
+    __m128i ctrl;
+#else
+    const int8_t *ctrl;
+#endif
+
+  public:
+#ifdef __SSE2__
+    explicit CtrlGroup(const int8_t *p)
+        : ctrl(_mm_loadu_si128((const __m128i *)p)) {}
+
+    uint32_t match(int8_t h2) const {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+    }
+
+    uint32_t matchEmptyOrDeleted() const { return _mm_movemask_epi8(ctrl); }
+#else
+    explicit CtrlGroup(const int8_t *p) : ctrl(p) {}
+
+    uint32_t match(int8_t h2) const {
+        uint32_t mask = 0;
+        for (int i = 0; i < GROUP_WIDTH; i++)
+            if (ctrl[i] == h2)
+                mask |= 1u << i;
+        return mask;
+    }
+
+    uint32_t matchEmptyOrDeleted() const {
+        uint32_t mask = 0;
+        for (int i = 0; i < GROUP_WIDTH; i++)
+            if (ctrl[i] < 0)
+                mask |= 1u << i;
+        return mask;
+    }
+#endif
+
+    uint32_t matchEmpty() const { return match(CTRL_EMPTY); }
+};
+
+// Index of the lowest set bit of a non-zero match mask
+inline int lowestBit(uint32_t mask) { return __builtin_ctz(mask); }
+
+// Group probing: 7-bit control tag of a key; probing starts at its home
+// slot. Groups are probed linearly, so ceil(size / GROUP_WIDTH) + 1 groups
+// cover the whole table.
+inline int8_t groupTag(const HashPair &h) { return (int8_t)(h.aux & 0x7F); }
+
+inline int groupCount(int m) { return m / GROUP_WIDTH + 2; }
+
+inline int groupSlot(int pos, int bit, int m) {
+    int index = pos + bit;
+    return (index < m) ? index : index % m;
+}
+
+// Starts loading the cache line of p without waiting for it
+inline void prefetch(const void *p) { __builtin_prefetch(p); }
+
+// Where the keys of a table of a given size go: the home bucket and probe
+// sequence of a HashPair. Shared by TableStorage and the mapped snapshots of
+// MappedHashTable.h.
+struct TableGeometry {
+    int size;
+    // Division-free reductions of the primary hash to [0, size) and of the
+    // aux hash to the probe step
+    RangeReducer homeReducer;
+    RangeReducer stepReducer;
+    bool powerOfTwo;
+
+    TableGeometry() : size(0), powerOfTwo(false) {}
+    explicit TableGeometry(int n)
+        : size(n), homeReducer(n), stepReducer(n - 1),
+          powerOfTwo((n & (n - 1)) == 0) {}
+
+    // Hash(k): bucket / first probe
+    int home(const HashPair &h) const { return homeReducer(h.primary); }
+
+    // auxHash(k): 1 + aux % (size - 1), or an odd step for power-of-two
+    // sizes; either way coprime with size, so double hashing visits every
+    // slot
+    int step(const HashPair &h) const {
+        if (powerOfTwo)
+            return (h.aux & (size - 1)) | 1;
+        return 1 + stepReducer(h.aux);
+    }
+
+    ProbeSequence probe(const HashPair &h, CollisionMethod method) const {
+        return ProbeSequence(home(h), method == ROBIN_HOOD ? 1 : step(h), size,
+                             method);
+    }
+
+    // Robin Hood: how far slot index is from the home of a key with hash h
+    int distance(int index, const HashPair &h) const {
+        int d = index - home(h);
+        return (d < 0) ? d + size : d;
+    }
+
+    int nextSlot(int index) const {
+        return (index + 1 == size) ? 0 : index + 1;
+    }
+
+    // Cuckoo hashing: first slot of the two buckets a key may sit in, from
+    // the primary and the aux hash. Sizes are powers of two.
+    int bucket1(const HashPair &h) const {
+        return home(h) & ~(CUCKOO_BUCKET_SLOTS - 1);
+    }
+
+    int bucket2(const HashPair &h) const {
+        return (int)((h.aux * (uint32_t)CUCKOO_BUCKET_SLOTS) & (size - 1));
+    }
+
+    // The other bucket of an entry found in the bucket starting at slot b
+    int otherBucket(const HashPair &h, int b) const {
+        int b1 = bucket1(h);
+        return (b1 == b) ? bucket2(h) : b1;
+    }
+};
+
+// Cuckoo hashing: 7-bit control tag of a key, from the high bits of both
+// hashes (the low ones pick its buckets)
+inline int8_t cuckooTag(const HashPair &h) {
+    return (int8_t)((h.primary ^ h.aux) >> 25);
+}
+
+// Bit 8 * i + 7 is set for each control byte i of the bucket at ctrl that
+// holds tag. A byte after a match may be reported as well, so matches are
+// confirmed against the stored hash anyway.
+inline uint32_t matchCuckooTag(const int8_t *ctrl, int8_t tag) {
+    uint32_t word;
+    memcpy(&word, ctrl, sizeof(word));
+    uint32_t x = word ^ (0x01010101u * (uint8_t)tag);
+    return (x - 0x01010101u) & ~x & 0x80808080u;
+}
+
+inline uint32_t matchCuckooFree(const int8_t *ctrl) {
+    uint32_t word;
+    memcpy(&word, ctrl, sizeof(word));
+    return word & 0x80808080u;
+}
+
+// One generation of buckets. Only the array used by the collision method is
+// allocated; during an incremental resize the old and the new generation
+// coexist until every old bucket has been migrated.
+template <typename K, typename V> struct TableStorage : TableGeometry {
+    int tombstones;                   // Deleted slots left by remove()
+    // Double hashing / custom probing: highest probe number any entry was
+    // placed at, so unsuccessful scans can stop after it
+    int longestProbe;
+    vector<ChainNode<K, V> *> chains; // For chaining
+    vector<Entry<K, V>> slots;        // For open addressing
+    // For group probing: one control byte per slot, followed by copies of
+    // the first GROUP_WIDTH - 1 bytes so a group can be loaded at any slot.
+    // For cuckoo hashing: one per slot, read a bucket at a time.
+    vector<int8_t> ctrl;
+    // Cuckoo hashing: keys for which no kick-out path was found
+    vector<Entry<K, V>> stash;
+
+    TableStorage() : tombstones(0), longestProbe(0) {}
+    TableStorage(int n, CollisionMethod m)
+        : TableGeometry(n), tombstones(0), longestProbe(0) {
+        if (m == CHAINING)
+            chains.resize(n, nullptr);
+        else
+            slots.resize(n);
+        if (m == GROUP_PROBING)
+            ctrl.resize(n + GROUP_WIDTH - 1, CTRL_EMPTY);
+        if (m == CUCKOO_HASHING)
+            ctrl.resize(n, CTRL_EMPTY);
+    }
+
+    // Open addressing entry at a slot index; for cuckoo hashing, indices
+    // from size on are in the stash
+    const Entry<K, V> &entry(int index) const {
+        return (index < size) ? slots[index] : stash[index - size];
+    }
+
+    void setCtrl(int i, int8_t c) {
+        ctrl[i] = c;
+        for (int j = i; j < GROUP_WIDTH - 1; j += size)
+            ctrl[size + j] = c;
+    }
+
+    void release() {
+        size = 0;
+        tombstones = 0;
+        longestProbe = 0;
+        vector<ChainNode<K, V> *>().swap(chains);
+        vector<Entry<K, V>>().swap(slots);
+        vector<int8_t>().swap(ctrl);
+        vector<Entry<K, V>>().swap(stash);
+    }
+};
+
+// Hash Table Class. K can be string, FixedString<N> to keep short keys inline
+// in the slots, an integer type, or any type with a matching Hash (returning
+// hash1/hash2 packed as in KeyHash) and KeyEqual.
+template <typename K, typename V, typename Hash = KeyHash<K>,
+          typename KeyEqual = equal_to<K>>
+class HashTable {
   private:
-    int tableSize;
     int numElements;
     CollisionMethod method;
     int hashFunctionType; // 1 or 2
+    SizePolicy sizePolicy;
+    double customMaxLoad; // 0: the default of the method
 
-    // For chaining
-    vector<ChainNode<V> *> chainTable;
+    Hash hasher;
+    KeyEqual keyEqual;
 
-    // For open addressing
-    vector<Entry<V>> openTable;
+    // Active generation; all inserts go here
+    TableStorage<K, V> table;
+
+    // Backing memory of all chain nodes, in both generations
+    ChainNodePool<K, V> nodePool;
+
+    // Incremental resizing: previous generation, the next bucket of it
+    // that still has to be migrated, and how many buckets each operation
+    // migrates. oldTable.size == 0 when idle.
+    bool incrementalResize;
+    TableStorage<K, V> oldTable;
+    int migrationIndex;
+    int migrationBucketsPerOp;
 
     // Statistics
     long long totalCollisions;
     long long totalProbes;
     long long searchOperations;
+    TableStats stats; // Detailed counters, see TableStats.h
+    long long bucketsMigrated;
+    // Inserts that found no free slot within probeLimit()
+    long long failedInserts;
 
     // For dynamic resizing
     int insertionsSinceExpansion;
     int deletionsSinceCompaction;
     int elementsAtLastResize;
 
-    // Prime number utilities
-    bool isPrime(int n) {
-        if (n <= 1)
-            return false;
-        if (n <= 3)
-            return true;
-        if (n % 2 == 0 || n % 3 == 0)
-            return false;
-        for (int i = 5; i * i <= n; i += 6) {
-            if (n % i == 0 || n % (i + 2) == 0)
-                return false;
-        }
-        return true;
-    }
-
-    int nextPrime(int n) {
-        if (n <= 2)
-            return 2;
-        int prime = (n % 2 == 0) ? n + 1 : n + 2;
-        while (!isPrime(prime))
-            prime += 2;
-        return prime;
-    }
-
     int prevPrime(int n) {
         if (n <= INITIAL_TABLE_SIZE)
             return INITIAL_TABLE_SIZE;
@@ -100,250 +633,939 @@ template <typename V> class HashTable {
         return (prime < INITIAL_TABLE_SIZE) ? INITIAL_TABLE_SIZE : prime;
     }
 
-    // Hash functions
-    int hash1(const string &key) {
-        unsigned long long hashValue = 0;
-        const int p = 31;
-        const int m = tableSize;
-        unsigned long long p_pow = 1;
-        for (char c : key) {
-            hashValue = (hashValue + (c - 'a' + 1) * p_pow) % m;
-            p_pow = (p_pow * p) % m;
+    // Hash functions, both computed in a single pass over the key by
+    // KeyHash. The selected one is the primary hash, the other one the aux
+    // hash. They are reduced to the table size only when probing.
+    HashPair hashKey(const K &key) const { return splitHash(hasher(key)); }
+
+    HashPair splitHash(uint64_t h) const {
+        return splitHashPair(h, hashFunctionType);
+    }
+
+    double maxLoadFactor() const {
+        if (customMaxLoad > 0)
+            return customMaxLoad;
+        if (method == GROUP_PROBING)
+            return GROUP_LOAD_FACTOR_THRESHOLD;
+        if (method == ROBIN_HOOD)
+            return ROBIN_HOOD_LOAD_FACTOR_THRESHOLD;
+        if (method == CUCKOO_HASHING)
+            return CUCKOO_LOAD_FACTOR_THRESHOLD;
+        return LOAD_FACTOR_THRESHOLD;
+    }
+
+    // Shrink below this. A quarter of a custom maximum: halving the table
+    // then leaves it half full, as growing does. Growth waits for
+    // elementsAtLastResize / 2 insertions, so with a higher minimum a table
+    // could fill up completely before it is allowed to grow again.
+    double minLoadFactor() const {
+        return (customMaxLoad > 0) ? customMaxLoad / 4 : COMPACTION_THRESHOLD;
+    }
+
+    // Rebuild once this fraction of the slots are tombstones. Near the
+    // maximum load they would otherwise take the last empty slots, and
+    // unsuccessful probes would run through the whole table.
+    double tombstoneLimit() const {
+        return min(TOMBSTONE_THRESHOLD, (1 - maxLoadFactor()) / 2);
+    }
+
+    // Probes an open addressing insert may take before the table grows.
+    // Tombstones fill slots too, up to tombstoneLimit().
+    int probeLimit() const {
+        if (method == CHAINING)
+            return table.size;
+        double full = maxLoadFactor() + tombstoneLimit();
+        int limit = (int)(INSERT_PROBE_FACTOR / (1 - full)) + 1;
+        return min(limit, table.size);
+    }
+
+    bool isMigrating() const { return oldTable.size > 0; }
+
+    // Lookup in a single generation. Returns the node / slot index holding
+    // key, or nullptr / -1 if it is not there.
+    ChainNode<K, V> *findNode(const TableStorage<K, V> &t, const K &key,
+                              const HashPair &h, int &probes) const {
+        int index = t.home(h);
+        probes++;
+        ChainNode<K, V> *current = t.chains[index];
+        while (current != nullptr) {
+            if (current->hash == h && keyEqual(current->key, key))
+                return current;
+            current = current->next;
+            probes++;
+        }
+        return nullptr;
+    }
+
+    int findSlot(const TableStorage<K, V> &t, const K &key, const HashPair &h,
+                 int &probes) const {
+        if (method == GROUP_PROBING)
+            return findGroupSlot(t, key, h, probes);
+        if (method == ROBIN_HOOD)
+            return findRobinHoodSlot(t, key, h, probes);
+        if (method == CUCKOO_HASHING)
+            return findCuckooSlot(t, key, h, probes);
+
+        ProbeSequence seq = t.probe(h, method);
+        for (int i = 0; i <= t.longestProbe; i++) {
+            int index = seq.next();
+            probes++;
+
+            const Entry<K, V> &e = t.slots[index];
+            if (!e.occupied)
+                break;
+
+            if (!e.deleted && e.hash == h && keyEqual(e.key, key))
+                return index;
+        }
+        return -1;
+    }
+
+    int findGroupSlot(const TableStorage<K, V> &t, const K &key,
+                      const HashPair &h, int &probes) const {
+        int8_t tag = groupTag(h);
+        int pos = t.home(h);
+        for (int g = groupCount(t.size); g > 0; g--) {
+            CtrlGroup group(&t.ctrl[pos]);
+            probes++;
+            for (uint32_t mask = group.match(tag); mask; mask &= mask - 1) {
+                int index = groupSlot(pos, lowestBit(mask), t.size);
+                const Entry<K, V> &e = t.slots[index];
+                if (e.hash == h && keyEqual(e.key, key))
+                    return index;
+            }
+            if (group.matchEmpty())
+                break;
+            pos = groupSlot(pos, GROUP_WIDTH, t.size);
+        }
+        return -1;
+    }
+
+    // Entries sit at least as far from their home as any entry before them
+    // on the same run, so the search can stop at the first resident closer
+    // to its home than key would be. Tombstones (only in an old generation
+    // being migrated) keep their hash and still count.
+    int findRobinHoodSlot(const TableStorage<K, V> &t, const K &key,
+                          const HashPair &h, int &probes) const {
+        int index = t.home(h);
+        for (int d = 0; d < t.size; d++) {
+            probes++;
+            const Entry<K, V> &e = t.slots[index];
+            if (!e.occupied || t.distance(index, e.hash) < d)
+                break;
+            if (!e.deleted && e.hash == h && keyEqual(e.key, key))
+                return index;
+            index = t.nextSlot(index);
+        }
+        return -1;
+    }
+
+    // At most two bucket reads, plus the stash if anything is in it
+    int findCuckooSlot(const TableStorage<K, V> &t, const K &key,
+                       const HashPair &h, int &probes) const {
+        int8_t tag = cuckooTag(h);
+        int b1 = t.bucket1(h), b2 = t.bucket2(h);
+        for (int b : {b1, b2}) {
+            probes++;
+            for (uint32_t mask = matchCuckooTag(&t.ctrl[b], tag); mask;
+                 mask &= mask - 1) {
+                int index = b + lowestBit(mask) / 8;
+                const Entry<K, V> &e = t.slots[index];
+                if (e.hash == h && keyEqual(e.key, key))
+                    return index;
+            }
+            if (b1 == b2)
+                break;
+        }
+        for (size_t i = 0; i < t.stash.size(); i++) {
+            probes++;
+            if (t.stash[i].hash == h && keyEqual(t.stash[i].key, key))
+                return t.size + (int)i;
+        }
+        return -1;
+    }
+
+    int findCuckooFree(const TableStorage<K, V> &t, int b) const {
+        uint32_t mask = matchCuckooFree(&t.ctrl[b]);
+        return mask ? b + lowestBit(mask) / 8 : -1;
+    }
+
+    void moveCuckooSlot(TableStorage<K, V> &t, int from, int to) {
+        t.slots[to] = std::move(t.slots[from]);
+        t.ctrl[to] = t.ctrl[from];
+    }
+
+    // Places an entry whose key is not in t into one of its buckets. If
+    // both are full, a breadth-first search over the alternative buckets of
+    // the residents finds the shortest chain of moves ending at a free slot,
+    // and the chain is shifted from its far end so every entry stays
+    // findable throughout. Entries for which no chain is found within
+    // CUCKOO_BFS_NODES buckets go to the stash.
+    void placeCuckoo(TableStorage<K, V> &t, Entry<K, V> &&entry) {
+        // A bucket reached by moving the entry in slot `from` (of the
+        // parent's bucket) out of the parent
+        struct Step {
+            int bucket;
+            int parent;
+            int from;
+        };
+        Step steps[CUCKOO_BFS_NODES];
+        int count = 0;
+        int b1 = t.bucket1(entry.hash), b2 = t.bucket2(entry.hash);
+        for (int b : {b1, b2}) {
+            int index = findCuckooFree(t, b);
+            if (index != -1) {
+                t.ctrl[index] = cuckooTag(entry.hash);
+                t.slots[index] = std::move(entry);
+                return;
+            }
+            steps[count++] = {b, -1, -1};
+        }
+
+        for (int i = 0; i < count; i++) {
+            for (int s = 0; s < CUCKOO_BUCKET_SLOTS; s++) {
+                int index = steps[i].bucket + s;
+                int next = t.otherBucket(t.slots[index].hash, steps[i].bucket);
+                bool onPath = false;
+                for (int j = i; j != -1 && !onPath; j = steps[j].parent)
+                    onPath = steps[j].bucket == next;
+                if (onPath)
+                    continue;
+                totalCollisions++;
+
+                int free = findCuckooFree(t, next);
+                if (free != -1) {
+                    // Shift the chain, last move first
+                    moveCuckooSlot(t, index, free);
+                    for (int j = i; steps[j].parent != -1; j = steps[j].parent) {
+                        moveCuckooSlot(t, steps[j].from, index);
+                        index = steps[j].from;
+                    }
+                    t.ctrl[index] = cuckooTag(entry.hash);
+                    t.slots[index] = std::move(entry);
+                    return;
+                }
+                if (count < CUCKOO_BFS_NODES)
+                    steps[count++] = {next, i, index};
+            }
         }
-        return (int)hashValue;
+        t.stash.push_back(std::move(entry));
     }
 
-    int hash2(const string &key) {
-        unsigned long long hash = 5381;
-        for (char c : key) {
-            hash = ((hash << 5) + hash) + c;
+    // Robin Hood insertion of an entry that is not in t, starting at index,
+    // d slots from its home: it takes the place of the first resident closer
+    // to its own home, which moves on in its place, and so on until an
+    // empty slot. Only used on the active generation, which never has
+    // tombstones.
+    void shiftIn(TableStorage<K, V> &t, int index, int d,
+                 Entry<K, V> &&entry) {
+        for (int i = 0; i < t.size; i++) {
+            Entry<K, V> &e = t.slots[index];
+            if (!e.occupied) {
+                e = std::move(entry);
+                return;
+            }
+            int resident = t.distance(index, e.hash);
+            if (resident < d) {
+                swap(e, entry);
+                d = resident;
+            }
+            totalCollisions++;
+            index = t.nextSlot(index);
+            d++;
         }
-        return (int)(hash % tableSize);
     }
 
-    int getHash(const string &key) {
-        return (hashFunctionType == 1) ? hash1(key) : hash2(key);
+    // Backward-shift deletion: the entries after index move one slot
+    // closer to their home until an empty slot or an entry already at its
+    // home, so no tombstone is left behind
+    void shiftOut(TableStorage<K, V> &t, int index) {
+        for (int i = 1; i < t.size; i++) {
+            int next = t.nextSlot(index);
+            Entry<K, V> &e = t.slots[next];
+            if (!e.occupied || t.distance(next, e.hash) == 0)
+                break;
+            t.slots[index] = std::move(e);
+            index = next;
+        }
+        t.slots[index] = Entry<K, V>();
     }
 
-    int auxHash(const string &key) {
-        // Aux hash must be independent of Primary hash
-        int h_val = (hashFunctionType == 1) ? hash2(key) : hash1(key);
-        return 1 + (h_val % (tableSize - 1));
+    // First empty or deleted slot on the group probe path of h
+    int findGroupFree(TableStorage<K, V> &t, const HashPair &h) {
+        int pos = t.home(h);
+        for (int g = groupCount(t.size); g > 0; g--) {
+            uint32_t mask = CtrlGroup(&t.ctrl[pos]).matchEmptyOrDeleted();
+            if (mask)
+                return groupSlot(pos, lowestBit(mask), t.size);
+            totalCollisions++;
+            pos = groupSlot(pos, GROUP_WIDTH, t.size);
+        }
+        return -1;
     }
 
-    // Probing Index Calculators
-    int getDoubleHash(const string &key, int i) {
-        // (Hash(k) + i * auxHash(k)) % N
-        long long h = getHash(key);
-        long long aux = auxHash(key);
-        return (int)((h + (long long)i * aux) % tableSize);
+    void fillGroupSlot(TableStorage<K, V> &t, int index, Entry<K, V> &&entry) {
+        if (t.ctrl[index] == CTRL_DELETED)
+            t.tombstones--;
+        t.setCtrl(index, groupTag(entry.hash));
+        t.slots[index] = std::move(entry);
     }
 
-    int getCustomHash(const string &key, int i) {
-        // (Hash(k) + C1*i*auxHash(k) + C2*i^2) % N
-        long long h = getHash(key);
-        long long aux = auxHash(key);
-        long long result =
-            (h + C1 * (long long)i * aux + C2 * (long long)i * i) % tableSize;
-        return (int)((result >= 0) ? result : result + tableSize);
+    // Group probing visits whole groups; print the first slot of each
+    void printGroupSequence(const K &key) {
+        HashPair h = hashKey(key);
+        int8_t tag = groupTag(h);
+        int pos = table.home(h);
+        for (int g = groupCount(table.size); g > 0; g--) {
+            if (g != groupCount(table.size))
+                cout << " -> ";
+            cout << pos;
+
+            CtrlGroup group(&table.ctrl[pos]);
+            bool found = false;
+            for (uint32_t mask = group.match(tag); mask; mask &= mask - 1) {
+                const Entry<K, V> &e =
+                    table.slots[groupSlot(pos, lowestBit(mask), table.size)];
+                if (e.hash == h && keyEqual(e.key, key))
+                    found = true;
+            }
+            if (found || group.matchEmpty())
+                break;
+            pos = groupSlot(pos, GROUP_WIDTH, table.size);
+        }
+        cout << endl;
     }
 
-    double getLoadFactor() { return (double)numElements / tableSize; }
+    enum InsertResult { INSERTED, DUPLICATE_KEY, NO_FREE_SLOT };
 
-    // Helper for internal insert (used by rehash)
-    bool insertInternal(const string &key, const V &value, bool isRehashing) {
+    // Places key into generation t. The first tombstone on the probe path
+    // is reused, but only after the rest of the path has been checked for a
+    // duplicate. Double hashing and custom probing only take a slot among
+    // the first probeLimit probes.
+    InsertResult insertInto(TableStorage<K, V> &t, const K &key,
+                            const HashPair &h, const V &value,
+                            int probeLimit) {
         if (method == CHAINING) {
-            int index = getHash(key);
+            int index = t.home(h);
 
-            if (chainTable[index] != nullptr) {
+            if (t.chains[index] != nullptr) {
                 totalCollisions++;
-                ChainNode<V> *current = chainTable[index];
+                ChainNode<K, V> *current = t.chains[index];
                 while (current != nullptr) {
-                    if (current->key == key)
-                        return false;
+                    if (current->hash == h && keyEqual(current->key, key))
+                        return DUPLICATE_KEY;
                     current = current->next;
                 }
             }
 
-            ChainNode<V> *newNode = new ChainNode<V>(key, value);
-            newNode->next = chainTable[index];
-            chainTable[index] = newNode;
-        } else {
-            int i = 0;
-            int index;
-            while (i < tableSize) {
-                if (method == DOUBLE_HASHING)
-                    index = getDoubleHash(key, i);
-                else
-                    index = getCustomHash(key, i);
+            ChainNode<K, V> *newNode = nodePool.allocate(key, value, h);
+            newNode->next = t.chains[index];
+            t.chains[index] = newNode;
+            return INSERTED;
+        }
 
-                if (!openTable[index].occupied || openTable[index].deleted) {
-                    openTable[index] = Entry<V>(key, value);
-                    break;
+        if (method == GROUP_PROBING) {
+            int probes = 0;
+            if (findGroupSlot(t, key, h, probes) != -1)
+                return DUPLICATE_KEY;
+            int index = findGroupFree(t, h);
+            if (index == -1)
+                return NO_FREE_SLOT;
+            fillGroupSlot(t, index, Entry<K, V>(key, value, h));
+            return INSERTED;
+        }
+
+        if (method == CUCKOO_HASHING) {
+            int probes = 0;
+            if (findCuckooSlot(t, key, h, probes) != -1)
+                return DUPLICATE_KEY;
+            // A full stash has already made the table grow (stashFull), so
+            // these keys collide at every size
+            if ((int)t.stash.size() >= CUCKOO_STASH_LIMIT)
+                throw runtime_error("HashTable: too many keys whose hashes "
+                                    "collide");
+            placeCuckoo(t, Entry<K, V>(key, value, h));
+            return INSERTED;
+        }
+
+        if (method == ROBIN_HOOD) {
+            // A duplicate could only be before the slot the key belongs in
+            int index = t.home(h);
+            for (int d = 0; d < t.size; d++) {
+                const Entry<K, V> &e = t.slots[index];
+                if (!e.occupied || t.distance(index, e.hash) < d) {
+                    shiftIn(t, index, d, Entry<K, V>(key, value, h));
+                    return INSERTED;
                 }
+                if (e.hash == h && keyEqual(e.key, key))
+                    return DUPLICATE_KEY;
+                totalCollisions++;
+                index = t.nextSlot(index);
+            }
+            return NO_FREE_SLOT;
+        }
 
-                if (openTable[index].occupied && !openTable[index].deleted &&
-                    openTable[index].key == key) {
-                    return false;
+        // Entries beyond probeLimit are possible when an earlier insert
+        // needed a longer sequence, so duplicates are looked for up to the
+        // longest probe, or the first empty slot
+        ProbeSequence seq = t.probe(h, method);
+        int scan = max(probeLimit, t.longestProbe + 1);
+        int free = -1, freeProbe = 0;
+        for (int i = 0; i < scan; i++) {
+            int index = seq.next();
+
+            const Entry<K, V> &e = t.slots[index];
+            if (free == -1 && i < probeLimit && (!e.occupied || e.deleted)) {
+                free = index;
+                freeProbe = i;
+            }
+            if (!e.occupied)
+                break;
+            if (!e.deleted && e.hash == h && keyEqual(e.key, key))
+                return DUPLICATE_KEY;
+
+            totalCollisions++;
+        }
+
+        if (free == -1)
+            return NO_FREE_SLOT;
+        if (t.slots[free].deleted)
+            t.tombstones--;
+        t.slots[free] = Entry<K, V>(key, value, h);
+        t.longestProbe = max(t.longestProbe, freeProbe);
+        return INSERTED;
+    }
+
+    // Moves an entry whose key is known to be absent into generation t,
+    // reusing its stored hash. t always has room: resizes keep its load
+    // below the maximum, and a migration ends before the next resize, so
+    // running out of slots is a bug and throws rather than lose the key.
+    void placeEntry(TableStorage<K, V> &t, Entry<K, V> &&entry) {
+        if (method == GROUP_PROBING) {
+            int index = findGroupFree(t, entry.hash);
+            if (index == -1)
+                throw logic_error("HashTable: no free slot to place entry");
+            fillGroupSlot(t, index, std::move(entry));
+            return;
+        }
+        if (method == ROBIN_HOOD) {
+            // entry may be an old generation slot, which must keep its hash
+            // as a tombstone: shiftIn would swap displaced residents into it
+            Entry<K, V> moved = std::move(entry);
+            shiftIn(t, t.home(moved.hash), 0, std::move(moved));
+            return;
+        }
+        if (method == CUCKOO_HASHING) {
+            placeCuckoo(t, std::move(entry));
+            return;
+        }
+
+        ProbeSequence seq = t.probe(entry.hash, method);
+        for (int i = 0; i < t.size; i++) {
+            int index = seq.next();
+            if (!t.slots[index].occupied || t.slots[index].deleted) {
+                if (t.slots[index].deleted)
+                    t.tombstones--;
+                t.slots[index] = std::move(entry);
+                t.longestProbe = max(t.longestProbe, i);
+                return;
+            }
+            totalCollisions++;
+        }
+        throw logic_error("HashTable: no free slot to place entry");
+    }
+
+    // Removes key from generation t. Open addressing slots become
+    // tombstones so that probe sequences passing through them stay intact;
+    // Robin Hood shifts the following entries back instead, except in an
+    // old generation, where that could move an entry behind migrationIndex.
+    // Cuckoo lookups do not depend on other slots, so the slot just empties.
+    bool removeFrom(TableStorage<K, V> &t, const K &key, const HashPair &h) {
+        if (method == CHAINING) {
+            int index = t.home(h);
+            ChainNode<K, V> **link = &t.chains[index];
+            while (*link != nullptr) {
+                if ((*link)->hash == h && keyEqual((*link)->key, key)) {
+                    ChainNode<K, V> *temp = *link;
+                    *link = temp->next;
+                    nodePool.release(temp);
+                    return true;
                 }
+                link = &(*link)->next;
+            }
+            return false;
+        }
 
-                totalCollisions++;
-                i++;
+        int probes = 0;
+        int index = findSlot(t, key, h, probes);
+        if (index == -1)
+            return false;
+        if (method == ROBIN_HOOD && &t == &table) {
+            shiftOut(t, index);
+            return true;
+        }
+        if (method == CUCKOO_HASHING) {
+            if (index >= t.size) {
+                t.stash.erase(t.stash.begin() + (index - t.size));
+            } else {
+                t.ctrl[index] = CTRL_EMPTY;
+                t.slots[index] = Entry<K, V>();
             }
-            if (i == tableSize)
+            return true;
+        }
+        if (method == GROUP_PROBING)
+            t.setCtrl(index, CTRL_DELETED);
+        else
+            t.slots[index].deleted = true;
+        t.tombstones++;
+        return true;
+    }
+
+    // Moves old bucket i into the active generation using the stored hashes.
+    // Chain nodes are relinked; open addressing slots that held an entry are
+    // left as tombstones so that probe sequences through the old generation
+    // stay intact. Empty slots stay empty: they still end those sequences
+    // where they always did, instead of every probe that misses in the old
+    // generation running on over the whole migrated part.
+    void migrateBucket(int i) {
+        if (method == CHAINING) {
+            ChainNode<K, V> *current = oldTable.chains[i];
+            oldTable.chains[i] = nullptr;
+            while (current != nullptr) {
+                ChainNode<K, V> *next = current->next;
+                int index = table.home(current->hash);
+                if (table.chains[index] != nullptr)
+                    totalCollisions++;
+                current->next = table.chains[index];
+                table.chains[index] = current;
+                current = next;
+            }
+        } else if (method == GROUP_PROBING) {
+            if (oldTable.ctrl[i] >= 0) {
+                placeEntry(table, std::move(oldTable.slots[i]));
+                oldTable.setCtrl(i, CTRL_DELETED);
+            }
+        } else if (method == CUCKOO_HASHING) {
+            // No tombstones needed; the stash goes with the last bucket
+            if (oldTable.ctrl[i] >= 0)
+                placeEntry(table, std::move(oldTable.slots[i]));
+            oldTable.ctrl[i] = CTRL_EMPTY;
+            if (i == oldTable.size - 1) {
+                for (Entry<K, V> &e : oldTable.stash)
+                    placeEntry(table, std::move(e));
+                oldTable.stash.clear();
+            }
+        } else {
+            Entry<K, V> &e = oldTable.slots[i];
+            if (e.occupied && !e.deleted) {
+                placeEntry(table, std::move(e));
+                e.deleted = true;
+            }
+        }
+    }
+
+    // Migrates up to count buckets of the old generation.
+    void migrateBuckets(int count) {
+        while (count-- > 0 && isMigrating()) {
+            migrateBucket(migrationIndex++);
+            bucketsMigrated++;
+            if (migrationIndex == oldTable.size)
+                oldTable.release();
+        }
+    }
+
+    // Migration work done as part of an ordinary operation
+    void migrationStep(int count) {
+        if (!isMigrating())
+            return;
+        StatsTimer start = stats.startTimer();
+        migrateBuckets(count);
+        stats.recordMigrationStep(start);
+    }
+
+    // Helper for internal insert
+    bool insertInternal(const K &key, const V &value, const HashPair &h) {
+        migrationStep(migrationBucketsPerOp);
+
+        if (isMigrating()) {
+            // Key may still live in a bucket that was not migrated yet
+            int probes = 0;
+            bool found = (method == CHAINING)
+                             ? findNode(oldTable, key, h, probes) != nullptr
+                             : findSlot(oldTable, key, h, probes) != -1;
+            if (found)
                 return false;
         }
 
+        InsertResult result = insertInto(table, key, h, value, probeLimit());
+        if (result == NO_FREE_SLOT) {
+            // Clustered probe path. Grow unless the table is nearly empty,
+            // where only colliding hashes cause that, or still migrating,
+            // then take the first free slot of the whole sequence, which
+            // reaches every slot.
+            failedInserts++;
+            if (!isMigrating() && getLoadFactor() > minLoadFactor())
+                rehash(grownSize());
+            result = insertInto(table, key, h, value, table.size);
+        }
+        if (result != INSERTED)
+            return false;
+
         numElements++;
-        if (!isRehashing) {
-            insertionsSinceExpansion++;
-            checkAndResize();
+        insertionsSinceExpansion++;
+        checkAndResize();
+        return true;
+    }
+
+    // First cache lines a lookup of h touches: the bucket head, or the home
+    // slot (and its control bytes)
+    void prefetchHome(const TableStorage<K, V> &t, const HashPair &h) const {
+        int index = t.home(h);
+        if (method == CHAINING) {
+            prefetch(&t.chains[index]);
+        } else if (method == CUCKOO_HASHING) {
+            // Both buckets: the control bytes, then the slots
+            int b1 = t.bucket1(h), b2 = t.bucket2(h);
+            prefetch(&t.ctrl[b1]);
+            prefetch(&t.ctrl[b2]);
+            prefetch(&t.slots[b1]);
+            prefetch(&t.slots[b2]);
+        } else {
+            if (method == GROUP_PROBING)
+                prefetch(&t.ctrl[index]);
+            prefetch(&t.slots[index]);
+        }
+    }
+
+    // Second step for chaining, once the bucket heads are cached: the first
+    // node of each chain
+    void prefetchChainHead(const TableStorage<K, V> &t,
+                           const HashPair &h) const {
+        ChainNode<K, V> *head = t.chains[t.home(h)];
+        if (head != nullptr)
+            prefetch(head);
+    }
+
+    // Hashes keys[0..n) into h and prefetches where their probes start
+    void prepareGroup(const K *keys, int n, HashPair *h) const {
+        for (int i = 0; i < n; i++) {
+            h[i] = hashKey(keys[i]);
+            prefetchHome(table, h[i]);
         }
+        if (method == CHAINING)
+            for (int i = 0; i < n; i++)
+                prefetchChainHead(table, h[i]);
+    }
+
+    bool removeInternal(const K &key, const HashPair &h) {
+        migrationStep(migrationBucketsPerOp);
+
+        if (!removeFrom(table, key, h) &&
+            (!isMigrating() || !removeFrom(oldTable, key, h)))
+            return false;
+
+        numElements--;
+        deletionsSinceCompaction++;
+        checkAndResize();
         return true;
     }
 
+    // Looks key up in the new generation first, then in the part not
+    // migrated yet
+    bool lookup(const K &key, const HashPair &h, V &value, int &probes) const {
+        for (const TableStorage<K, V> *t : {&table, &oldTable}) {
+            if (t->size == 0)
+                continue;
+            if (method == CHAINING) {
+                ChainNode<K, V> *node = findNode(*t, key, h, probes);
+                if (node != nullptr) {
+                    value = node->value;
+                    return true;
+                }
+            } else {
+                int index = findSlot(*t, key, h, probes);
+                if (index != -1) {
+                    value = t->entry(index).value;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    static int initialSize(SizePolicy policy) {
+        return (policy == POWER_OF_TWO_SIZES) ? INITIAL_POWER_OF_TWO_SIZE
+                                              : INITIAL_TABLE_SIZE;
+    }
+
+    // Custom probing only reaches every slot with its triangular sequence
+    // on power-of-two sizes, and cuckoo buckets need a size divisible by
+    // CUCKOO_BUCKET_SLOTS, so both always use powers of two
+    static SizePolicy policyFor(CollisionMethod m, SizePolicy requested) {
+        if (m == CUSTOM_PROBING || m == CUCKOO_HASHING)
+            return POWER_OF_TWO_SIZES;
+        return requested;
+    }
+
+    // Cuckoo hashing: grow once the stash fills up. Below half full a
+    // working hash practically never needs the stash, so there it means
+    // keys whose hashes collide outright, which growing would not separate;
+    // they may fill it up to CUCKOO_STASH_LIMIT, which forces one growth
+    // anyway, and an insert that still finds it that full throws.
+    bool stashFull() const {
+        if (method != CUCKOO_HASHING)
+            return false;
+        int stashed = table.stash.size();
+        return stashed >= CUCKOO_STASH_LIMIT ||
+               (stashed >= CUCKOO_STASH_SIZE &&
+                getLoadFactor() > LOAD_FACTOR_THRESHOLD);
+    }
+
+    int grownSize() {
+        return (sizePolicy == POWER_OF_TWO_SIZES) ? 2 * table.size
+                                                  : nextPrime(2 * table.size);
+    }
+
+    // A migration is paced to end before growth or shrinking can be due
+    // (see rehash); a full stash or a tombstone rebuild waits for its end.
     void checkAndResize() {
+        if (isMigrating())
+            return;
         double loadFactor = getLoadFactor();
-        if (loadFactor > LOAD_FACTOR_THRESHOLD &&
-            insertionsSinceExpansion >= elementsAtLastResize / 2) {
-            rehash(nextPrime(2 * tableSize));
-        } else if (loadFactor < COMPACTION_THRESHOLD &&
-                   tableSize > INITIAL_TABLE_SIZE &&
+        int minSize = initialSize(sizePolicy);
+        if ((loadFactor > maxLoadFactor() &&
+             insertionsSinceExpansion >= elementsAtLastResize / 2) ||
+            stashFull()) {
+            rehash(grownSize());
+        } else if (loadFactor < minLoadFactor() &&
+                   table.size > minSize &&
                    deletionsSinceCompaction >= elementsAtLastResize / 2) {
-            int newSize = prevPrime(tableSize / 2);
-            if (newSize < INITIAL_TABLE_SIZE)
-                newSize = INITIAL_TABLE_SIZE;
+            int newSize = (sizePolicy == POWER_OF_TWO_SIZES)
+                              ? table.size / 2
+                              : prevPrime(table.size / 2);
+            if (newSize < minSize)
+                newSize = minSize;
             rehash(newSize);
+        } else if (method != CHAINING &&
+                   table.tombstones > tombstoneLimit() * table.size) {
+            // Same size, but without the tombstones lengthening probe paths
+            rehash(table.size);
         }
     }
 
+    // Starts a new generation of newSize buckets. In blocking mode every old
+    // bucket is migrated right away; in incremental mode the work is spread
+    // over the following operations. Allocating the new generation is still
+    // O(newSize), here, in either mode.
     void rehash(int newSize) {
-        int oldSize = tableSize;
-        vector<ChainNode<V> *> oldChainTable = chainTable;
-        vector<Entry<V>> oldOpenTable = openTable;
+        if (isMigrating())
+            throw logic_error("HashTable: resize during a migration");
+        StatsTimer start = stats.startTimer();
+
+        // Rebuilding at the same size only drops tombstones; growth and
+        // shrinking stay paced by the last real resize, or a table near its
+        // maximum load could fill up before it is allowed to grow
+        if (newSize != table.size) {
+            insertionsSinceExpansion = 0;
+            deletionsSinceCompaction = 0;
+            elementsAtLastResize = numElements;
+        }
 
-        tableSize = newSize;
-        numElements = 0;
-        insertionsSinceExpansion = 0;
-        deletionsSinceCompaction = 0;
+        oldTable = std::move(table);
+        table = TableStorage<K, V>(newSize, method);
+        migrationIndex = 0;
 
+        if (!incrementalResize) {
+            migrateBuckets(oldTable.size);
+        } else {
+            // Growing or shrinking again takes elementsAtLastResize / 2
+            // inserts or removes, counted since the last real resize; each
+            // of them (the one that triggers it too) migrates first
+            int opsLeft = max(1, elementsAtLastResize / 2 -
+                                     max(insertionsSinceExpansion,
+                                         deletionsSinceCompaction));
+            migrationBucketsPerOp =
+                max(MIGRATION_BUCKETS_PER_OP,
+                    (oldTable.size + opsLeft - 1) / opsLeft);
+        }
+        stats.recordResize(start);
+    }
+
+    // Cluster or chain lengths of the active generation. A cluster is a run
+    // of non-empty slots (tombstones included), i.e. what a probe starting
+    // in it may have to pass; runs wrap around the end of the table.
+    void addStructure(StatsSnapshot &s) const {
         if (method == CHAINING) {
-            chainTable.clear();
-            chainTable.resize(tableSize, nullptr);
-            for (int i = 0; i < oldSize; i++) {
-                ChainNode<V> *current = oldChainTable[i];
-                while (current != nullptr) {
-                    insertInternal(current->key, current->value, true);
-                    ChainNode<V> *temp = current;
-                    current = current->next;
-                    delete temp;
-                }
+            for (ChainNode<K, V> *node : table.chains) {
+                int length = 0;
+                for (; node != nullptr; node = node->next)
+                    length++;
+                if (length > 0)
+                    s.chainLengths.add(length);
             }
-        } else {
-            openTable.clear();
-            openTable.resize(tableSize);
-            for (int i = 0; i < oldSize; i++) {
-                if (oldOpenTable[i].occupied && !oldOpenTable[i].deleted) {
-                    insertInternal(oldOpenTable[i].key, oldOpenTable[i].value,
-                                   true);
-                }
+            return;
+        }
+        // Cuckoo lookups do not walk runs of slots
+        if (method == CUCKOO_HASHING)
+            return;
+
+        auto empty = [&](int i) {
+            return method == GROUP_PROBING ? table.ctrl[i] == CTRL_EMPTY
+                                           : !table.slots[i].occupied;
+        };
+        int firstEmpty = 0;
+        while (firstEmpty < table.size && !empty(firstEmpty))
+            firstEmpty++;
+        if (firstEmpty == table.size) {
+            s.clusterLengths.add(table.size);
+            return;
+        }
+        int run = 0;
+        for (int k = 1; k <= table.size; k++) {
+            int i = (firstEmpty + k) % table.size;
+            if (!empty(i)) {
+                run++;
+            } else if (run > 0) {
+                s.clusterLengths.add(run);
+                run = 0;
             }
         }
-        elementsAtLastResize = numElements;
     }
 
   public:
-    HashTable(CollisionMethod m, int hashType)
-        : tableSize(INITIAL_TABLE_SIZE), numElements(0), method(m),
-          hashFunctionType(hashType), totalCollisions(0), totalProbes(0),
-          searchOperations(0), insertionsSinceExpansion(0),
-          deletionsSinceCompaction(0), elementsAtLastResize(0) {
+    HashTable(CollisionMethod m, int hashType, bool incremental = false,
+              SizePolicy sizes = PRIME_SIZES, const Hash &hash = Hash(),
+              const KeyEqual &equal = KeyEqual())
+        : numElements(0), method(m), hashFunctionType(hashType),
+          sizePolicy(policyFor(m, sizes)), customMaxLoad(0), hasher(hash),
+          keyEqual(equal),
+          table(initialSize(sizePolicy), m),
+          incrementalResize(incremental),
+          migrationIndex(0), migrationBucketsPerOp(MIGRATION_BUCKETS_PER_OP),
+          totalCollisions(0), totalProbes(0),
+          searchOperations(0), bucketsMigrated(0), failedInserts(0),
+          insertionsSinceExpansion(0), deletionsSinceCompaction(0),
+          elementsAtLastResize(0) {}
 
-        if (method == CHAINING) {
-            chainTable.resize(tableSize, nullptr);
-        } else {
-            openTable.resize(tableSize);
-        }
+    bool insert(const K &key, const V &value) {
+        return insertInternal(key, value, hashKey(key));
     }
 
-    ~HashTable() {
-        if (method == CHAINING) {
-            for (auto node : chainTable) {
-                while (node) {
-                    ChainNode<V> *temp = node;
-                    node = node->next;
-                    delete temp;
-                }
+    bool search(const K &key, V &value) {
+        migrationStep(migrationBucketsPerOp);
+        searchOperations++;
+        int probes = 0;
+        bool found = lookup(key, hashKey(key), value, probes);
+        totalProbes += probes;
+        stats.recordLookup(found, probes);
+        return found;
+    }
+
+    // Batched versions of insert / search. Keys are processed in groups of
+    // BATCH_GROUP_SIZE: the whole group is hashed and the first cache line
+    // of every key prefetched before any of them is resolved, so the cache
+    // misses of a group overlap instead of being paid one after the other.
+    // inserted / found may be nullptr; values[i] is only written for keys
+    // that were found. Both return the number of keys inserted / found.
+    int insertBatch(const K *keys, const V *values, int count,
+                    bool *inserted = nullptr) {
+        HashPair h[BATCH_GROUP_SIZE];
+        int total = 0;
+        for (int start = 0; start < count; start += BATCH_GROUP_SIZE) {
+            int n = min(BATCH_GROUP_SIZE, count - start);
+            prepareGroup(keys + start, n, h);
+            for (int i = 0; i < n; i++) {
+                bool ok = insertInternal(keys[start + i], values[start + i],
+                                         h[i]);
+                if (inserted != nullptr)
+                    inserted[start + i] = ok;
+                total += ok;
             }
         }
+        return total;
     }
 
-    bool insert(const string &key, const V &value) {
-        return insertInternal(key, value, false);
+    int searchBatch(const K *keys, int count, V *values,
+                    bool *found = nullptr) {
+        HashPair h[BATCH_GROUP_SIZE];
+        int total = 0;
+        for (int start = 0; start < count; start += BATCH_GROUP_SIZE) {
+            int n = min(BATCH_GROUP_SIZE, count - start);
+            migrationStep(migrationBucketsPerOp * n);
+            prepareGroup(keys + start, n, h);
+            for (int i = 0; i < n; i++) {
+                int probes = 0;
+                bool ok = lookup(keys[start + i], h[i], values[start + i],
+                                 probes);
+                if (found != nullptr)
+                    found[start + i] = ok;
+                total += ok;
+                totalProbes += probes;
+                stats.recordLookup(ok, probes);
+            }
+            searchOperations += n;
+        }
+        return total;
     }
 
-    bool search(const string &key, V &value) {
-        searchOperations++;
+    // Lookup that changes nothing but the thread-local TableStats counters:
+    // no migration step and no running totals, so any number of threads may
+    // call it concurrently as long as no thread modifies the table (see
+    // ShardedHashTable)
+    bool find(const K &key, V &value) const {
         int probes = 0;
+        bool found = lookup(key, hashKey(key), value, probes);
+        stats.recordLookup(found, probes);
+        return found;
+    }
 
-        if (method == CHAINING) {
-            int index = getHash(key);
-            probes++;
-            ChainNode<V> *current = chainTable[index];
-            while (current != nullptr) {
-                if (current->key == key) {
-                    value = current->value;
-                    totalProbes += probes;
-                    return true;
-                }
-                current = current->next;
-                probes++;
-            }
-        } else {
-            int i = 0;
-            int index;
-            while (i < tableSize) {
-                if (method == DOUBLE_HASHING)
-                    index = getDoubleHash(key, i);
-                else
-                    index = getCustomHash(key, i);
+    // Variants for callers that already computed hash = Hash()(key), e.g. to
+    // pick a shard; probes of find() are added to probes
+    uint64_t hashOf(const K &key) const { return hasher(key); }
 
-                probes++;
+    bool insert(const K &key, const V &value, uint64_t hash) {
+        return insertInternal(key, value, splitHash(hash));
+    }
 
-                if (!openTable[index].occupied)
-                    break;
+    bool remove(const K &key, uint64_t hash) {
+        return removeInternal(key, splitHash(hash));
+    }
 
-                if (openTable[index].occupied && !openTable[index].deleted &&
-                    openTable[index].key == key) {
-                    value = openTable[index].value;
-                    totalProbes += probes;
-                    return true;
-                }
-                i++;
-            }
-        }
-        totalProbes += probes;
-        return false;
+    bool find(const K &key, V &value, uint64_t hash, int &probes) const {
+        int before = probes;
+        bool found = lookup(key, splitHash(hash), value, probes);
+        stats.recordLookup(found, probes - before);
+        return found;
     }
 
      // --- NEW: Print Probe Sequence Method [cite: 3, 4] ---
         void
-        printProbeSequence(const string &key) {
+        printProbeSequence(const K &key) {
             if (method == CHAINING) {
                 cout << "Probe sequence not supported for Chaining." << endl;
                 return;
             }
+            if (method == GROUP_PROBING) {
+                printGroupSequence(key);
+                return;
+            }
+            if (method == CUCKOO_HASHING) {
+                // First slot of each of the two buckets
+                HashPair h = hashKey(key);
+                cout << table.bucket1(h) << " -> " << table.bucket2(h) << endl;
+                return;
+            }
 
             int i = 0;
             int index;
             bool first = true;
+            const vector<Entry<K, V>> &openTable = table.slots;
+            HashPair h = hashKey(key);
+            ProbeSequence seq = table.probe(h, method);
 
             // Traverse using the same probing logic as search/insert
-            while (i < tableSize) {
-                if (method == DOUBLE_HASHING)
-                    index = getDoubleHash(key, i);
-                else
-                    index = getCustomHash(key, i);
+            while (i < table.size) {
+                index = seq.next();
 
                 if (!first)
                     cout << " -> ";
@@ -352,7 +1574,8 @@ template <typename V> class HashTable {
 
                 // Stop Condition 1: Key found
                 if (openTable[index].occupied && !openTable[index].deleted &&
-                    openTable[index].key == key) {
+                    openTable[index].hash == h &&
+                    keyEqual(openTable[index].key, key)) {
                     break;
                 }
 
@@ -361,6 +1584,12 @@ template <typename V> class HashTable {
                     break;
                 }
 
+                // Stop Condition 3 (Robin Hood): resident closer to its home
+                if (method == ROBIN_HOOD &&
+                    table.distance(index, openTable[index].hash) < i) {
+                    break;
+                }
+
                 // Otherwise, collision occurred (or DELETED slot), continue to
                 // next probe
                 i++;
@@ -368,50 +1597,145 @@ template <typename V> class HashTable {
             cout << endl;
         }
 
-    bool remove(const string &key) {
-        // Implementation omitted for brevity
-        return false;
+    bool remove(const K &key) { return removeInternal(key, hashKey(key)); }
+
+    int getSize() const { return numElements; }
+
+    int getCapacity() const { return table.size; }
+
+    double getLoadFactor() const { return (double)numElements / table.size; }
+
+    // Grow once the load factor exceeds f (and shrink below f / 4) instead
+    // of the method's default thresholds. Open addressing needs f < 1.
+    void setMaxLoadFactor(double f) {
+        if (f <= 0 || (method != CHAINING && f >= 1))
+            throw invalid_argument("HashTable: load factor out of range");
+        customMaxLoad = f;
     }
 
     long long getCollisions() const { return totalCollisions; }
 
+    // Inserts that had to grow the table, or probe past the usual limit,
+    // to find a slot; none of them were dropped
+    long long getFailedInserts() const { return failedInserts; }
+
+    int getTombstoneCount() const { return table.tombstones; }
+
+    double getTombstoneDensity() const {
+        return (double)table.tombstones / table.size;
+    }
+
     double getAverageProbes() const {
         return searchOperations > 0 ? (double)totalProbes / searchOperations
                                     : 0.0;
     }
 
-    void resetStatistics() {
-        totalCollisions = 0;
-        totalProbes = 0;
-        searchOperations = 0;
+    // Incremental resize progress
+    bool isResizing() const { return isMigrating(); }
+
+    long long getMigratedBuckets() const { return bucketsMigrated; }
+
+    double getMigrationProgress() const {
+        return isMigrating() ? (double)migrationIndex / oldTable.size : 1.0;
     }
-};
 
-// Random Word Generator Class
-class WordGenerator {
-  private:
-    mt19937 gen;
-    uniform_int_distribution<> dis;
-    set<string> generatedWords;
+    // Writes the table to path in the position-independent layout of
+    // SnapshotFormat.h, which MappedHashTable maps back without copying or
+    // rehashing. A pending incremental resize is completed first. K must be
+    // a string or trivially copyable, V trivially copyable.
+    void saveSnapshot(const string &path) {
+        static_assert(is_trivially_copyable<V>::value,
+                      "snapshot values must be trivially copyable");
+        migrateBuckets(oldTable.size);
 
-  public:
-    WordGenerator() : gen(42), dis(0, 25) {}
-
-    string generateWord(int length) {
-        string word;
-        while (true) {
-            word = "";
-            for (int i = 0; i < length; i++) {
-                word += char('a' + dis(gen));
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.method = method;
+        header.hashFunctionType = hashFunctionType;
+        header.c1 = C1;
+        header.c2 = C2;
+        header.keySize = SnapshotKeyCodec<K>::SIZE;
+        header.valueSize = sizeof(V);
+        header.slotSize = sizeof(SnapshotSlot<V>);
+        header.capacity = table.size;
+        header.elements = numElements;
+        header.tombstones = table.tombstones;
+
+        vector<SnapshotSlot<V>> slots;
+        vector<uint64_t> buckets;
+        string arena;
+        auto add = [&](const K *key, const V *value, const HashPair &h,
+                       uint32_t state) {
+            SnapshotSlot<V> slot;
+            memset((void *)&slot, 0, sizeof(slot)); // No stray padding bytes
+            slot.primary = h.primary;
+            slot.aux = h.aux;
+            slot.state = state;
+            if (state == SNAPSHOT_FULL) {
+                string_view bytes = snapshotKeyBytes(*key);
+                slot.keyOffset = arena.size();
+                slot.keyLength = bytes.size();
+                arena.append(bytes.data(), bytes.size());
+                slot.value = *value;
             }
-            if (generatedWords.find(word) == generatedWords.end()) {
-                generatedWords.insert(word);
-                return word;
+            slots.push_back(slot);
+        };
+
+        if (method == CHAINING) {
+            buckets.resize(table.size + 1);
+            for (int b = 0; b < table.size; b++) {
+                buckets[b] = slots.size();
+                for (ChainNode<K, V> *n = table.chains[b]; n; n = n->next)
+                    add(&n->key, &n->value, n->hash, SNAPSHOT_FULL);
+            }
+            buckets[table.size] = slots.size();
+        } else {
+            slots.reserve(table.size);
+            for (int i = 0; i < table.size; i++) {
+                const Entry<K, V> &e = table.slots[i];
+                uint32_t state;
+                if (method == GROUP_PROBING || method == CUCKOO_HASHING)
+                    state = table.ctrl[i] >= 0 ? SNAPSHOT_FULL
+                            : table.ctrl[i] == CTRL_DELETED ? SNAPSHOT_DELETED
+                                                            : SNAPSHOT_EMPTY;
+                else
+                    state = !e.occupied ? SNAPSHOT_EMPTY
+                            : e.deleted ? SNAPSHOT_DELETED
+                                        : SNAPSHOT_FULL;
+                add(&e.key, &e.value, e.hash, state);
             }
+            for (const Entry<K, V> &e : table.stash)
+                add(&e.key, &e.value, e.hash, SNAPSHOT_FULL);
         }
+        header.ctrlBytes = table.ctrl.size();
+        header.bucketCount = buckets.size();
+        header.slotCount = slots.size();
+        writeSnapshotFile(path, header, table.ctrl.data(), buckets.data(),
+                          slots.data(), arena);
+    }
+
+    // Probe-length histograms and resize counters (with HASHTABLE_STATS),
+    // plus the current cluster / chain lengths, which take a walk over the
+    // table. Cheap enough to scrape periodically; like find(), it may run
+    // concurrently with readers but not with writers.
+    StatsSnapshot getStatsSnapshot() const {
+        StatsSnapshot s = stats.snapshot();
+        s.size = numElements;
+        s.capacity = table.size;
+        s.tombstones = table.tombstones + oldTable.tombstones;
+        s.failedInserts = failedInserts;
+        addStructure(s);
+        return s;
     }
 
-    void reset() { generatedWords.clear(); }
+    void resetStatistics() {
+        totalCollisions = 0;
+        totalProbes = 0;
+        searchOperations = 0;
+        stats.reset();
+    }
 };
 
 #endif // HASHTABLE_H
\ No newline at end of file
@@ -0,0 +1,273 @@
+#ifndef INPUTREADER_H
+#define INPUTREADER_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Whitespace-separated integers and words from a file or a pipe, without
+// iostream extraction and without a string per token. A regular file is
+// mapped and tokens point straight into the mapping; anything else (stdin
+// from a pipe or terminal) is read in large blocks. Separators are found 16
+// bytes at a time with SSE2, and integers are parsed 8 digits at a time.
+//
+// Any byte up to ' ' (spaces, tabs, newlines, other control characters)
+// separates tokens. Malformed integers throw runtime_error.
+//
+// Tokens of a mapped file stay valid as long as the reader; tokens of block
+// reads only until the next call, which may move the buffer.
+
+const size_t INPUT_BLOCK_SIZE = 1 << 20;
+
+#ifdef __SSE2__
+// Bit i set if p[i] is a separator, i.e. (unsigned) p[i] <= ' '
+inline uint32_t separatorMask(const char *p) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *)p);
+    __m128i low = _mm_min_epu8(bytes, _mm_set1_epi8(' '));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(low, bytes));
+}
+#endif
+
+inline bool isSeparator(char c) { return (unsigned char)c <= ' '; }
+
+// First non-separator in [p, end), or end
+inline const char *skipSeparators(const char *p, const char *end) {
+#ifdef __SSE2__
+    for (; end - p >= 16; p += 16) {
+        uint32_t token = ~separatorMask(p) & 0xFFFF;
+        if (token)
+            return p + __builtin_ctz(token);
+    }
+#endif
+    while (p < end && isSeparator(*p))
+        p++;
+    return p;
+}
+
+// First separator in [p, end), or end
+inline const char *findSeparator(const char *p, const char *end) {
+#ifdef __SSE2__
+    for (; end - p >= 16; p += 16) {
+        uint32_t separators = separatorMask(p);
+        if (separators)
+            return p + __builtin_ctz(separators);
+    }
+#endif
+    while (p < end && !isSeparator(*p))
+        p++;
+    return p;
+}
+
+// Eight ASCII digits loaded little-endian into a word: all of them digits,
+// and their value (SWAR, three multiplications)
+inline bool isEightDigits(uint64_t chunk) {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >>
+             4)) == 0x3333333333333333ULL;
+}
+
+inline uint32_t parseEightDigits(uint64_t chunk) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+    chunk -= 0x3030303030303030ULL;
+    chunk = chunk * 10 + (chunk >> 8); // Pairs of digits
+    return (uint32_t)((((chunk & mask) * mul1) +
+                       (((chunk >> 16) & mask) * mul2)) >>
+                      32);
+}
+
+// Optional sign and up to 19 digits, in the range of int64_t
+inline int64_t parseInt64(string_view token) {
+    const char *p = token.data(), *end = p + token.size();
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    if (p == end || end - p > 19)
+        throw runtime_error("input: bad integer '" + string(token) + "'");
+
+    uint64_t value = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; end - p >= 8; p += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, p, 8);
+        if (!isEightDigits(chunk))
+            throw runtime_error("input: bad integer '" + string(token) + "'");
+        value = value * 100000000 + parseEightDigits(chunk);
+    }
+#endif
+    for (; p < end; p++) {
+        unsigned digit = (unsigned char)*p - '0';
+        if (digit > 9)
+            throw runtime_error("input: bad integer '" + string(token) + "'");
+        value = value * 10 + digit;
+    }
+
+    uint64_t limit = (uint64_t)numeric_limits<int64_t>::max() + negative;
+    if (value > limit)
+        throw runtime_error("input: integer out of range '" + string(token) +
+                            "'");
+    return negative ? (int64_t)(0 - value) : (int64_t)value;
+}
+
+class InputReader {
+  private:
+    int fd;
+    bool ownsFd;
+    char *mapped; // Whole file, or nullptr for block reads
+    size_t mappedLength;
+    vector<char> buffer;
+    const char *pos, *end;
+    bool eof; // No input beyond end
+
+    void init(bool mapIfPossible) {
+        struct stat st;
+        if (mapIfPossible && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+            st.st_size > 0) {
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                mapped = (char *)p;
+                mappedLength = st.st_size;
+                pos = mapped;
+                end = mapped + mappedLength;
+                eof = true;
+                return;
+            }
+        }
+        buffer.resize(INPUT_BLOCK_SIZE);
+        pos = end = buffer.data();
+    }
+
+    // Keeps the unconsumed bytes and appends the next block; a token
+    // longer than the buffer doubles it
+    void refill() {
+        size_t kept = end - pos;
+        memmove(buffer.data(), pos, kept);
+        if (kept == buffer.size())
+            buffer.resize(2 * buffer.size());
+        ssize_t n;
+        do
+            n = read(fd, buffer.data() + kept, buffer.size() - kept);
+        while (n < 0 && errno == EINTR);
+        if (n < 0)
+            throw runtime_error("input: read failed");
+        if (n == 0)
+            eof = true;
+        pos = buffer.data();
+        end = pos + kept + n;
+    }
+
+    // Next token among the bytes already read. False if there is none, or
+    // it may continue in input not read yet.
+    bool bufferedToken(string_view &token) {
+        const char *start = skipSeparators(pos, end);
+        pos = start;
+        if (start == end)
+            return false;
+        const char *stop = findSeparator(start, end);
+        if (stop == end && !eof)
+            return false;
+        token = string_view(start, stop - start);
+        pos = stop;
+        return true;
+    }
+
+  public:
+    // Reads fd, which stays open (0: stdin)
+    explicit InputReader(int inputFd = 0, bool mapIfPossible = true)
+        : fd(inputFd), ownsFd(false), mapped(nullptr), mappedLength(0),
+          eof(false) {
+        init(mapIfPossible);
+    }
+
+    explicit InputReader(const string &path, bool mapIfPossible = true)
+        : fd(open(path.c_str(), O_RDONLY)), ownsFd(true), mapped(nullptr),
+          mappedLength(0), eof(false) {
+        if (fd < 0)
+            throw runtime_error("input: cannot open " + path);
+        init(mapIfPossible);
+    }
+    InputReader(const InputReader &) = delete;
+    InputReader &operator=(const InputReader &) = delete;
+
+    ~InputReader() {
+        if (mapped != nullptr)
+            munmap(mapped, mappedLength);
+        if (ownsFd)
+            close(fd);
+    }
+
+    bool isMapped() const { return mapped != nullptr; }
+
+    // Next token, or false at the end of the input
+    bool nextWord(string_view &word) {
+        while (!bufferedToken(word)) {
+            if (eof)
+                return false;
+            refill();
+        }
+        return true;
+    }
+
+    bool nextInt(int64_t &value) {
+        string_view token;
+        if (!nextWord(token))
+            return false;
+        value = parseInt64(token);
+        return true;
+    }
+
+    // Up to max next tokens into words (cleared first); returns how many.
+    // Fewer than max before the end of the input when block reads need to
+    // move the buffer, so every view in the batch stays valid.
+    size_t nextWords(vector<string_view> &words, size_t max) {
+        words.clear();
+        string_view token;
+        while (words.size() < max) {
+            if (bufferedToken(token)) {
+                words.push_back(token);
+                continue;
+            }
+            if (eof || !words.empty())
+                break;
+            refill();
+        }
+        return words.size();
+    }
+
+    // Up to max next integers into values (cleared first); returns how
+    // many, 0 only at the end of the input
+    size_t nextInts(vector<int64_t> &values, size_t max) {
+        values.clear();
+        string_view token;
+        while (values.size() < max) {
+            if (bufferedToken(token)) {
+                values.push_back(parseInt64(token));
+                continue;
+            }
+            if (eof)
+                break;
+            refill();
+        }
+        return values.size();
+    }
+};
+
+#endif // INPUTREADER_H
@@ -0,0 +1,510 @@
+#ifndef LOCKFREEHASHTABLE_H
+#define LOCKFREEHASHTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "HashTable.h"
+
+using namespace std;
+
+// ---------------- EPOCH-BASED RECLAMATION ----------------
+
+const int MAX_EPOCH_THREADS = 256;
+// Retirements between two attempts to advance the epoch and free memory
+const int RETIRE_SCAN_INTERVAL = 64;
+
+// Memory unlinked from a lock-free structure may still be read by threads
+// that loaded a pointer to it earlier. Every operation runs inside an epoch
+// (EpochGuard); memory retired during global epoch e is freed once the
+// global epoch reached e + 2, because by then every thread has left the
+// epochs in which it could have seen the pointer.
+//
+// One process-wide domain; each thread owns one record from first use until
+// it exits.
+class EpochDomain {
+  private:
+    static const uint64_t QUIESCENT = ~0ULL;
+
+    struct Retired {
+        void *ptr;
+        void (*deleter)(void *);
+        uint64_t epoch;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) ThreadRecord {
+        atomic<uint64_t> epoch{QUIESCENT}; // Epoch the thread is in
+        atomic<bool> inUse{false};
+        int nesting = 0;         // Only touched by the owning thread,
+        vector<Retired> retired; // as is this list
+    };
+
+    // Claims a record for the calling thread and frees it when the thread
+    // exits. Its retired list stays behind for the next owner (or the
+    // destructor).
+    struct RecordOwner {
+        EpochDomain &domain;
+        int index;
+
+        explicit RecordOwner(EpochDomain &d) : domain(d), index(-1) {
+            for (int i = 0; i < MAX_EPOCH_THREADS; i++) {
+                bool expected = false;
+                if (d.records[i].inUse.compare_exchange_strong(expected,
+                                                               true)) {
+                    index = i;
+                    return;
+                }
+            }
+            throw runtime_error("EpochDomain: more than MAX_EPOCH_THREADS");
+        }
+        ~RecordOwner() { domain.records[index].inUse.store(false); }
+    };
+
+    alignas(CACHE_LINE_SIZE) atomic<uint64_t> globalEpoch{1};
+    ThreadRecord records[MAX_EPOCH_THREADS];
+
+    ThreadRecord &self() {
+        thread_local RecordOwner owner(*this);
+        return records[owner.index];
+    }
+
+    // The epoch can advance once every thread inside an epoch is in the
+    // current one
+    void tryAdvance() {
+        uint64_t e = globalEpoch.load();
+        for (ThreadRecord &r : records) {
+            uint64_t local = r.epoch.load();
+            if (local != QUIESCENT && local != e)
+                return;
+        }
+        globalEpoch.compare_exchange_strong(e, e + 1);
+    }
+
+    void reclaim(ThreadRecord &r) {
+        uint64_t e = globalEpoch.load();
+        size_t kept = 0;
+        for (Retired &item : r.retired) {
+            if (item.epoch + 2 <= e)
+                item.deleter(item.ptr);
+            else
+                r.retired[kept++] = item;
+        }
+        r.retired.resize(kept);
+    }
+
+    EpochDomain() {}
+
+  public:
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    static EpochDomain &instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // Process exit: no thread can hold a pointer any more
+    ~EpochDomain() {
+        for (ThreadRecord &r : records)
+            for (Retired &item : r.retired)
+                item.deleter(item.ptr);
+    }
+
+    void enter() {
+        ThreadRecord &r = self();
+        if (r.nesting++ == 0) {
+            r.epoch.store(globalEpoch.load());
+            // The epoch must be visible before any pointer is loaded
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+    }
+
+    void exit() {
+        ThreadRecord &r = self();
+        if (--r.nesting == 0)
+            r.epoch.store(QUIESCENT, memory_order_release);
+    }
+
+    // Frees ptr with deleter once no thread can still be reading it
+    void retire(void *ptr, void (*deleter)(void *)) {
+        ThreadRecord &r = self();
+        r.retired.push_back({ptr, deleter, globalEpoch.load()});
+        if (r.retired.size() % RETIRE_SCAN_INTERVAL == 0) {
+            tryAdvance();
+            reclaim(r);
+        }
+    }
+
+    int registeredThreads() const {
+        int count = 0;
+        for (const ThreadRecord &r : records)
+            count += r.inUse.load(memory_order_relaxed);
+        return count;
+    }
+};
+
+class EpochGuard {
+  public:
+    EpochGuard() { EpochDomain::instance().enter(); }
+    ~EpochGuard() { EpochDomain::instance().exit(); }
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+// ---------------- LOCK-FREE HASH TABLE ----------------
+
+// Slots hold a pointer to an immutable node; the low bits carry the slot
+// state (nodes are 8-byte aligned).
+const uintptr_t SLOT_DELETED = 1; // Key logically removed
+const uintptr_t SLOT_FROZEN = 2;  // Being moved to the next table; final
+const uintptr_t SLOT_COPIED = 4;  // Frozen, and its key is in the next table
+const uintptr_t SLOT_TAGS = 7;
+
+// Slots handed to a resize helper at a time
+const int COPY_CHUNK = 256;
+
+template <typename K, typename V> struct alignas(8) LockFreeNode {
+    K key;
+    V value;
+    HashPair hash;
+};
+
+template <typename K, typename V> struct LockFreeTable {
+    int size;
+    RangeReducer homeReducer;
+    RangeReducer stepReducer;
+    unique_ptr<atomic<uintptr_t>[]> slots;
+
+    // Slots that ever held a key. Slots are never emptied again (a removed
+    // key keeps its slot, so the key's position stays unique), so this only
+    // goes up until the table is replaced.
+    alignas(CACHE_LINE_SIZE) atomic<int> claimed{0};
+
+    // Resize state: the successor and the next chunk of slots to copy
+    atomic<LockFreeTable *> next{nullptr};
+    atomic<int> copyCursor{0};
+    atomic<int> copied{0};
+
+    explicit LockFreeTable(int n)
+        : size(n), homeReducer(n), stepReducer(n - 1),
+          slots(new atomic<uintptr_t>[n]) {
+        for (int i = 0; i < n; i++)
+            slots[i].store(0, memory_order_relaxed);
+    }
+
+    // Double hashing; size is prime, so every slot is visited
+    ProbeSequence probe(const HashPair &h) const {
+        return ProbeSequence(homeReducer(h.primary), 1 + stepReducer(h.aux),
+                             size, DOUBLE_HASHING);
+    }
+};
+
+// Concurrent DOUBLE_HASHING map without locks.
+//   insert: insert-if-absent; claims an empty slot (or revives the removed
+//           key's own slot) with a single CAS
+//   search: wait-free; at most size probes in one table, never helps or
+//           retries
+//   remove: logical; CAS sets SLOT_DELETED, the node is freed when the slot
+//           is reused by the same key or the table is dropped
+// A full table (claimed slots above LOAD_FACTOR_THRESHOLD, tombstones
+// included) is replaced cooperatively: writers that run into it freeze and
+// copy chunks of slots into the successor, and whoever finishes last
+// publishes it. Nodes are shared between the tables, never copied. Unlinked
+// nodes and tables are reclaimed through EpochDomain.
+//
+// Sizes are primes, starting at INITIAL_TABLE_SIZE. The destructor must not
+// run concurrently with other operations.
+template <typename K, typename V, typename Hash = KeyHash<K>,
+          typename KeyEqual = equal_to<K>>
+class LockFreeHashTable {
+  private:
+    typedef LockFreeNode<K, V> Node;
+    typedef LockFreeTable<K, V> Table;
+
+    enum Outcome { DONE, NOT_DONE, NEEDS_RESIZE };
+
+    int hashFunctionType; // 1 or 2
+    Hash hasher;
+    KeyEqual keyEqual;
+
+    alignas(CACHE_LINE_SIZE) atomic<Table *> current;
+    // Written by every insert and remove; kept off the line readers load
+    alignas(CACHE_LINE_SIZE) atomic<long long> liveKeys{0};
+    atomic<long long> resizes{0};
+
+    static Node *nodeOf(uintptr_t slot) {
+        return (Node *)(slot & ~SLOT_TAGS);
+    }
+
+    static void deleteNode(void *p) { delete (Node *)p; }
+
+    // Frees a replaced table. Its removed keys' nodes were not carried over
+    // and die with it; live nodes belong to the successor now.
+    static void deleteTable(void *p) {
+        Table *t = (Table *)p;
+        for (int i = 0; i < t->size; i++) {
+            uintptr_t v = t->slots[i].load(memory_order_relaxed);
+            if (v & SLOT_DELETED)
+                delete nodeOf(v);
+        }
+        delete t;
+    }
+
+    bool matches(const Node *n, const K &key, const HashPair &h) const {
+        return n->hash == h && keyEqual(n->key, key);
+    }
+
+    static bool isFull(const Table *t) {
+        return t->claimed.load(memory_order_relaxed) >=
+               t->size * LOAD_FACTOR_THRESHOLD;
+    }
+
+    // DONE: inserted. NOT_DONE: key present. node is allocated on first
+    // need and handed over (set to nullptr) on success.
+    Outcome tryInsert(Table *t, const K &key, const V &value,
+                      const HashPair &h, Node *&node) {
+        if (t->next.load(memory_order_acquire) != nullptr)
+            return NEEDS_RESIZE;
+
+        ProbeSequence seq = t->probe(h);
+        for (int i = 0; i < t->size; i++) {
+            atomic<uintptr_t> &slot = t->slots[seq.next()];
+            uintptr_t v = slot.load(memory_order_acquire);
+            while (true) {
+                if (v & SLOT_FROZEN)
+                    return NEEDS_RESIZE;
+                Node *n = nodeOf(v);
+                if (n != nullptr && !matches(n, key, h))
+                    break; // Another key's slot
+                if (n != nullptr && !(v & SLOT_DELETED))
+                    return NOT_DONE;
+                if (n == nullptr && isFull(t))
+                    return NEEDS_RESIZE;
+
+                if (node == nullptr)
+                    node = new Node{key, value, h};
+                // On failure v is reloaded and the slot examined again
+                if (slot.compare_exchange_weak(v, (uintptr_t)node,
+                                               memory_order_acq_rel,
+                                               memory_order_acquire)) {
+                    node = nullptr;
+                    if (n == nullptr)
+                        t->claimed.fetch_add(1, memory_order_relaxed);
+                    else
+                        EpochDomain::instance().retire(n, deleteNode);
+                    return DONE;
+                }
+            }
+        }
+        return NEEDS_RESIZE;
+    }
+
+    // DONE: removed. NOT_DONE: key absent.
+    Outcome tryRemove(Table *t, const K &key, const HashPair &h) {
+        if (t->next.load(memory_order_acquire) != nullptr)
+            return NEEDS_RESIZE;
+
+        ProbeSequence seq = t->probe(h);
+        for (int i = 0; i < t->size; i++) {
+            atomic<uintptr_t> &slot = t->slots[seq.next()];
+            uintptr_t v = slot.load(memory_order_acquire);
+            while (true) {
+                if (v & SLOT_FROZEN)
+                    return NEEDS_RESIZE;
+                Node *n = nodeOf(v);
+                if (n == nullptr)
+                    return NOT_DONE;
+                if (!matches(n, key, h))
+                    break;
+                if (v & SLOT_DELETED)
+                    return NOT_DONE;
+                if (slot.compare_exchange_weak(v, v | SLOT_DELETED,
+                                               memory_order_acq_rel,
+                                               memory_order_acquire))
+                    return DONE;
+            }
+        }
+        return NOT_DONE;
+    }
+
+    // Puts a live node of a frozen slot into the successor. Several helpers
+    // may copy the same node, and a slow one may still be at it after the
+    // successor was published and the key removed or replaced there. The
+    // first copy fixes the key's slot for good, and every later copy stops
+    // at that slot (same key), so the node is placed exactly once.
+    void copyNode(Table *to, Node *node) {
+        ProbeSequence seq = to->probe(node->hash);
+        for (int i = 0; i < to->size; i++) {
+            atomic<uintptr_t> &slot = to->slots[seq.next()];
+            uintptr_t v = slot.load(memory_order_acquire);
+            while (v == 0) {
+                if (slot.compare_exchange_weak(v, (uintptr_t)node,
+                                               memory_order_acq_rel,
+                                               memory_order_acquire)) {
+                    to->claimed.fetch_add(1, memory_order_relaxed);
+                    return;
+                }
+            }
+            Node *n = nodeOf(v);
+            if (n == nullptr || n == node || matches(n, node->key, node->hash))
+                return;
+        }
+        throw logic_error("LockFreeHashTable: successor table is full");
+    }
+
+    // Freezes slot i of t and copies it. Returns 1 if this call marked it
+    // copied, so every slot is counted exactly once.
+    int copySlot(Table *t, Table *to, int i) {
+        atomic<uintptr_t> &slot = t->slots[i];
+        uintptr_t v = slot.load(memory_order_acquire);
+        while (!(v & SLOT_FROZEN)) {
+            if (slot.compare_exchange_weak(v, v | SLOT_FROZEN,
+                                           memory_order_acq_rel,
+                                           memory_order_acquire))
+                v |= SLOT_FROZEN;
+        }
+        if (v & SLOT_COPIED)
+            return 0;
+        Node *n = nodeOf(v);
+        if (n != nullptr && !(v & SLOT_DELETED))
+            copyNode(to, n);
+        return slot.compare_exchange_strong(v, v | SLOT_COPIED) ? 1 : 0;
+    }
+
+    // Starts the resize of t if nobody has, helps copying, and returns once
+    // t is no longer the current table
+    void helpResize(Table *t) {
+        Table *to = t->next.load(memory_order_acquire);
+        if (to == nullptr) {
+            // Room for the live keys four times over (so the successor
+            // starts at most a quarter full), plus one in-flight insert per
+            // thread that passed its resize check on t
+            long long live = liveKeys.load(memory_order_relaxed);
+            int threads = EpochDomain::instance().registeredThreads();
+            long long wanted = max<long long>(INITIAL_TABLE_SIZE,
+                                              4 * live + 2 * threads);
+            Table *fresh = new Table(nextPrime((int)wanted));
+            if (t->next.compare_exchange_strong(to, fresh))
+                to = fresh;
+            else
+                delete fresh; // Lost the race; to is the winner's table
+        }
+
+        while (true) {
+            int start = t->copyCursor.fetch_add(COPY_CHUNK);
+            if (start >= t->size)
+                break;
+            int end = min(start + COPY_CHUNK, t->size);
+            int done = 0;
+            for (int i = start; i < end; i++)
+                done += copySlot(t, to, i);
+            if (done > 0)
+                t->copied.fetch_add(done);
+        }
+        // All chunks are handed out. If their owners have not finished
+        // (or stalled), finish every slot here; copySlot is idempotent.
+        if (t->copied.load() < t->size) {
+            int done = 0;
+            for (int i = 0; i < t->size; i++)
+                done += copySlot(t, to, i);
+            if (done > 0)
+                t->copied.fetch_add(done);
+        }
+
+        Table *expected = t;
+        if (current.compare_exchange_strong(expected, to)) {
+            resizes.fetch_add(1, memory_order_relaxed);
+            EpochDomain::instance().retire(t, deleteTable);
+        }
+    }
+
+  public:
+    LockFreeHashTable(int hashType = 1, const Hash &hash = Hash(),
+                      const KeyEqual &equal = KeyEqual())
+        : hashFunctionType(hashType), hasher(hash), keyEqual(equal),
+          current(new Table(INITIAL_TABLE_SIZE)) {}
+
+    LockFreeHashTable(const LockFreeHashTable &) = delete;
+    LockFreeHashTable &operator=(const LockFreeHashTable &) = delete;
+
+    // Every operation has completed, so no resize is pending: the current
+    // table owns every node still reachable
+    ~LockFreeHashTable() {
+        Table *t = current.load();
+        for (int i = 0; i < t->size; i++)
+            delete nodeOf(t->slots[i].load(memory_order_relaxed));
+        delete t;
+    }
+
+    // Returns false, and leaves the value alone, if key is present
+    bool insert(const K &key, const V &value) {
+        EpochGuard guard;
+        HashPair h = splitHashPair(hasher(key), hashFunctionType);
+        Node *node = nullptr;
+        while (true) {
+            Table *t = current.load(memory_order_acquire);
+            Outcome result = tryInsert(t, key, value, h, node);
+            if (result == NEEDS_RESIZE) {
+                helpResize(t);
+                continue;
+            }
+            delete node; // Only still set if the key was present
+            if (result == DONE)
+                liveKeys.fetch_add(1, memory_order_relaxed);
+            return result == DONE;
+        }
+    }
+
+    // A frozen table is never modified again, so readers keep probing the
+    // table they started in: its state is one the map had during the call
+    bool search(const K &key, V &value) const {
+        EpochGuard guard;
+        HashPair h = splitHashPair(hasher(key), hashFunctionType);
+        const Table *t = current.load(memory_order_acquire);
+        ProbeSequence seq = t->probe(h);
+        for (int i = 0; i < t->size; i++) {
+            uintptr_t v = t->slots[seq.next()].load(memory_order_acquire);
+            const Node *n = nodeOf(v);
+            if (n == nullptr)
+                return false;
+            if (matches(n, key, h)) {
+                if (v & SLOT_DELETED)
+                    return false;
+                value = n->value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool remove(const K &key) {
+        EpochGuard guard;
+        HashPair h = splitHashPair(hasher(key), hashFunctionType);
+        while (true) {
+            Table *t = current.load(memory_order_acquire);
+            Outcome result = tryRemove(t, key, h);
+            if (result == NEEDS_RESIZE) {
+                helpResize(t);
+                continue;
+            }
+            if (result == DONE)
+                liveKeys.fetch_sub(1, memory_order_relaxed);
+            return result == DONE;
+        }
+    }
+
+    // Exact only while no writer is running
+    long long getSize() const { return liveKeys.load(); }
+
+    int getCapacity() const {
+        EpochGuard guard;
+        return current.load()->size;
+    }
+
+    long long getResizeCount() const { return resizes.load(); }
+};
+
+#endif // LOCKFREEHASHTABLE_H
@@ -0,0 +1,253 @@
+#ifndef MAPPEDHASHTABLE_H
+#define MAPPEDHASHTABLE_H
+
+#include <climits>
+#include <stdexcept>
+#include <string>
+
+#include "HashTable.h"
+
+using namespace std;
+
+enum SnapshotMode { SNAPSHOT_READ_ONLY, SNAPSHOT_COPY_ON_WRITE };
+
+// A HashTable snapshot (see HashTable::saveSnapshot) used in place through
+// mmap. Opening only checks the header and a sample of the stored hashes;
+// nothing is copied or rehashed, and pages are read in as lookups touch
+// them.
+//
+// Keys sit where the saved table put them, so the collision method, hash
+// type, C1 / C2 and Hash functor must be the ones that built it; opening
+// with anything else throws runtime_error. Keys are compared by their bytes
+// (see snapshotKeyBytes) instead of with a KeyEqual.
+//
+// SNAPSHOT_COPY_ON_WRITE also allows update() and remove(). Their changes
+// only reach this process' private copies of the touched pages; the file is
+// never modified.
+template <typename K, typename V, typename Hash = KeyHash<K>>
+class MappedHashTable {
+  private:
+    MappedFile file;
+    SnapshotHeader *header;
+    CollisionMethod method;
+    int hashFunctionType;
+    SnapshotMode mode;
+    Hash hasher;
+    TableGeometry geometry;
+    int8_t *ctrl;      // GROUP_PROBING, CUCKOO_HASHING
+    uint64_t *buckets; // CHAINING
+    SnapshotSlot<V> *slots;
+    const char *arena;
+
+    [[noreturn]] static void reject(const string &what) {
+        throw runtime_error("snapshot: " + what);
+    }
+
+    bool sectionFits(uint64_t offset, uint64_t bytes) const {
+        return offset % SNAPSHOT_ALIGNMENT == 0 && offset <= file.size() &&
+               bytes <= file.size() - offset;
+    }
+
+    void validate() const {
+        const SnapshotHeader &h = *header;
+        if (file.size() < sizeof(SnapshotHeader) ||
+            memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+            reject("not a snapshot file");
+        if (h.version != SNAPSHOT_VERSION || h.fileSize != file.size())
+            reject("unsupported version or truncated file");
+        if (h.method != (uint32_t)method)
+            reject("saved with another collision method");
+        if (h.hashFunctionType != hashFunctionType)
+            reject("saved with another hash function type");
+        if (h.c1 != C1 || h.c2 != C2)
+            reject("saved with other custom probing constants C1 / C2");
+        if (h.keySize != SnapshotKeyCodec<K>::SIZE ||
+            h.valueSize != sizeof(V) || h.slotSize != sizeof(SnapshotSlot<V>))
+            reject("saved with other key or value types");
+
+        uint64_t expectedSlots = (method == CHAINING) ? h.elements : h.capacity;
+        uint64_t expectedCtrl =
+            (method == GROUP_PROBING) ? h.capacity + GROUP_WIDTH - 1 : 0;
+        uint64_t expectedBuckets = (method == CHAINING) ? h.capacity + 1 : 0;
+        if (method == CUCKOO_HASHING) {
+            // Plus the stash, at most every key
+            expectedSlots = max(h.slotCount, h.capacity);
+            expectedCtrl = h.capacity;
+            if ((h.capacity & (h.capacity - 1)) != 0 ||
+                h.capacity % CUCKOO_BUCKET_SLOTS != 0 ||
+                h.slotCount - h.capacity > h.elements)
+                reject("corrupt cuckoo table size");
+        }
+        if (h.capacity < 2 || h.capacity > INT_MAX ||
+            h.slotCount != expectedSlots || h.ctrlBytes != expectedCtrl ||
+            h.bucketCount != expectedBuckets ||
+            !sectionFits(h.ctrlOffset, h.ctrlBytes) ||
+            !sectionFits(h.bucketsOffset, h.bucketCount * sizeof(uint64_t)) ||
+            !sectionFits(h.slotsOffset, h.slotCount * h.slotSize) ||
+            h.arenaOffset > h.fileSize ||
+            h.arenaBytes != h.fileSize - h.arenaOffset)
+            reject("corrupt section table");
+    }
+
+    string_view keyOf(const SnapshotSlot<V> &s) const {
+        return string_view(arena + s.keyOffset, s.keyLength);
+    }
+
+    // The first stored keys must hash to their stored HashPair, otherwise
+    // every probe sequence would differ from the saved table's
+    void checkHashes() const {
+        int checked = 0;
+        for (uint64_t i = 0;
+             i < header->slotCount && checked < SNAPSHOT_HASH_CHECKS; i++) {
+            const SnapshotSlot<V> &s = slots[i];
+            if (s.state != SNAPSHOT_FULL)
+                continue;
+            if (s.keyOffset > header->arenaBytes ||
+                s.keyLength > header->arenaBytes - s.keyOffset ||
+                (header->keySize != 0 && s.keyLength != header->keySize))
+                reject("corrupt key reference");
+            K key = SnapshotKeyCodec<K>::decode(keyOf(s));
+            HashPair h = splitHashPair(hasher(key), hashFunctionType);
+            if (h.primary != s.primary || h.aux != s.aux)
+                reject("saved with another Hash functor");
+            checked++;
+        }
+    }
+
+    SnapshotSlot<V> *findSlot(const K &key) const {
+        HashPair h = splitHashPair(hasher(key), hashFunctionType);
+        string_view bytes = snapshotKeyBytes(key);
+        auto matches = [&](const SnapshotSlot<V> &s) {
+            return s.primary == h.primary && s.aux == h.aux &&
+                   keyOf(s) == bytes;
+        };
+
+        if (method == CHAINING) {
+            int b = geometry.home(h);
+            for (uint64_t i = buckets[b]; i < buckets[b + 1]; i++)
+                if (slots[i].state == SNAPSHOT_FULL && matches(slots[i]))
+                    return &slots[i];
+            return nullptr;
+        }
+
+        if (method == GROUP_PROBING) {
+            int8_t tag = groupTag(h);
+            int pos = geometry.home(h);
+            for (int g = groupCount(geometry.size); g > 0; g--) {
+                CtrlGroup group(&ctrl[pos]);
+                for (uint32_t mask = group.match(tag); mask; mask &= mask - 1) {
+                    SnapshotSlot<V> &s =
+                        slots[groupSlot(pos, lowestBit(mask), geometry.size)];
+                    if (matches(s))
+                        return &s;
+                }
+                if (group.matchEmpty())
+                    break;
+                pos = groupSlot(pos, GROUP_WIDTH, geometry.size);
+            }
+            return nullptr;
+        }
+
+        if (method == CUCKOO_HASHING) {
+            int8_t tag = cuckooTag(h);
+            for (int b : {geometry.bucket1(h), geometry.bucket2(h)})
+                for (uint32_t mask = matchCuckooTag(&ctrl[b], tag); mask;
+                     mask &= mask - 1) {
+                    SnapshotSlot<V> &s = slots[b + lowestBit(mask) / 8];
+                    if (matches(s))
+                        return &s;
+                }
+            for (uint64_t i = header->capacity; i < header->slotCount; i++)
+                if (slots[i].state == SNAPSHOT_FULL && matches(slots[i]))
+                    return &slots[i];
+            return nullptr;
+        }
+
+        ProbeSequence seq = geometry.probe(h, method);
+        for (int i = 0; i < geometry.size; i++) {
+            int index = seq.next();
+            SnapshotSlot<V> &s = slots[index];
+            if (s.state == SNAPSHOT_EMPTY)
+                break;
+            // Robin Hood: no key beyond a resident closer to its home
+            if (method == ROBIN_HOOD &&
+                geometry.distance(index, {s.primary, s.aux}) < i)
+                break;
+            if (s.state == SNAPSHOT_FULL && matches(s))
+                return &s;
+        }
+        return nullptr;
+    }
+
+    void requireWritable() const {
+        if (mode != SNAPSHOT_COPY_ON_WRITE)
+            throw logic_error("MappedHashTable: snapshot opened read-only");
+    }
+
+  public:
+    MappedHashTable(const string &path, CollisionMethod m, int hashType,
+                    SnapshotMode openMode = SNAPSHOT_READ_ONLY,
+                    const Hash &hash = Hash())
+        : file(path, openMode == SNAPSHOT_COPY_ON_WRITE),
+          header((SnapshotHeader *)file.bytes()), method(m),
+          hashFunctionType(hashType), mode(openMode), hasher(hash) {
+        validate();
+        geometry = TableGeometry((int)header->capacity);
+        ctrl = (int8_t *)(file.bytes() + header->ctrlOffset);
+        buckets = (uint64_t *)(file.bytes() + header->bucketsOffset);
+        slots = (SnapshotSlot<V> *)(file.bytes() + header->slotsOffset);
+        arena = file.bytes() + header->arenaOffset;
+        checkHashes();
+    }
+
+    bool search(const K &key, V &value) const {
+        const SnapshotSlot<V> *s = findSlot(key);
+        if (s == nullptr)
+            return false;
+        value = s->value;
+        return true;
+    }
+
+    // Copy-on-write only: new value for a key that is already there
+    bool update(const K &key, const V &value) {
+        requireWritable();
+        SnapshotSlot<V> *s = findSlot(key);
+        if (s == nullptr)
+            return false;
+        s->value = value;
+        return true;
+    }
+
+    // Copy-on-write only: the slot becomes a tombstone, as in HashTable.
+    // Robin Hood slots too; their stored hash keeps the early exit valid.
+    // Cuckoo slots simply become empty.
+    bool remove(const K &key) {
+        requireWritable();
+        SnapshotSlot<V> *s = findSlot(key);
+        if (s == nullptr)
+            return false;
+        header->elements--;
+        if (method == CUCKOO_HASHING) {
+            uint64_t i = s - slots;
+            if (i < header->capacity)
+                ctrl[i] = CTRL_EMPTY;
+            s->state = SNAPSHOT_EMPTY;
+            return true;
+        }
+        s->state = SNAPSHOT_DELETED;
+        if (method == GROUP_PROBING) {
+            int i = (int)(s - slots);
+            ctrl[i] = CTRL_DELETED;
+            for (int j = i; j < GROUP_WIDTH - 1; j += geometry.size)
+                ctrl[geometry.size + j] = CTRL_DELETED;
+        }
+        header->tombstones++;
+        return true;
+    }
+
+    int getSize() const { return (int)header->elements; }
+
+    int getCapacity() const { return geometry.size; }
+};
+
+#endif // MAPPEDHASHTABLE_H
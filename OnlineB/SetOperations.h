@@ -0,0 +1,297 @@
+#ifndef SETOPERATIONS_H
+#define SETOPERATIONS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "HashTable.h"
+#include "Workload.h"
+
+using namespace std;
+
+// Union, intersection and difference of two sets of integer keys that are
+// streamed in batch by batch. Every distinct key is stored once, in one of
+// SET_PARTITIONS tables chosen by the high bits of its hash, together with
+// a mask of the inputs it was seen in; the three results then come out of
+// one scan over the partitions. With several threads a batch is first
+// scattered by partition, and each partition is filled by a single thread.
+
+const int SET_PARTITIONS = 256;
+// Keys per block when batches are scattered and results sorted in parallel
+const int SET_BLOCK = 1 << 16;
+// Membership tables grow beyond this load; linear probing
+const double SET_MAX_LOAD = 0.7;
+
+enum SetInput : uint8_t { SET_A = 1, SET_B = 2 };
+
+struct SetCardinalities {
+    uint64_t a = 0;            // Distinct keys of A
+    uint64_t b = 0;            // Distinct keys of B
+    uint64_t unionSize = 0;    // A | B
+    uint64_t intersection = 0; // A & B
+    uint64_t difference = 0;   // A - B
+};
+
+template <typename K> struct SetResults {
+    vector<K> unionKeys;
+    vector<K> intersection;
+    vector<K> difference; // A - B
+};
+
+// Orders integer keys as unsigned numbers: the sign bit of signed types is
+// flipped, so negative keys come first
+template <typename K> inline uint64_t radixKey(K key) {
+    typedef typename make_unsigned<K>::type U;
+    uint64_t u = (U)key;
+    if (is_signed<K>::value)
+        u ^= (uint64_t)1 << (8 * sizeof(K) - 1);
+    return u;
+}
+
+// Stable LSD radix sort of integer keys, a byte per pass. Each pass counts
+// the digits of every block in parallel, turns the counts into per-block
+// output offsets, and scatters the blocks in parallel. Passes whose digit is
+// the same for every key are skipped, so small key ranges take few passes.
+template <typename K>
+void radixSort(vector<K> &keys, int threads = 0) {
+    static_assert(is_integral<K>::value, "radixSort: integer keys only");
+    threads = workloadThreads(threads);
+    size_t n = keys.size();
+    if (n < 2)
+        return;
+    uint64_t blocks = (n + SET_BLOCK - 1) / SET_BLOCK;
+    vector<K> buffer(n);
+    vector<uint64_t> offsets(blocks * 256);
+
+    for (int shift = 0; shift < 8 * (int)sizeof(K); shift += 8) {
+        fill(offsets.begin(), offsets.end(), 0);
+        parallelFor(blocks, threads, [&](uint64_t b) {
+            size_t end = min(n, (size_t)(b + 1) * SET_BLOCK);
+            uint64_t *count = &offsets[b * 256];
+            for (size_t i = b * SET_BLOCK; i < end; i++)
+                count[(radixKey(keys[i]) >> shift) & 0xFF]++;
+        });
+
+        uint64_t running = 0;
+        bool oneDigit = false;
+        for (int d = 0; d < 256; d++) {
+            uint64_t before = running;
+            for (uint64_t b = 0; b < blocks; b++) {
+                uint64_t c = offsets[b * 256 + d];
+                offsets[b * 256 + d] = running;
+                running += c;
+            }
+            if (running - before == n)
+                oneDigit = true;
+        }
+        if (oneDigit)
+            continue;
+
+        parallelFor(blocks, threads, [&](uint64_t b) {
+            size_t end = min(n, (size_t)(b + 1) * SET_BLOCK);
+            uint64_t *next = &offsets[b * 256];
+            for (size_t i = b * SET_BLOCK; i < end; i++)
+                buffer[next[(radixKey(keys[i]) >> shift) & 0xFF]++] = keys[i];
+        });
+        keys.swap(buffer);
+    }
+}
+
+template <typename K, typename Hash = KeyHash<K>> class SetAlgebra {
+    static_assert(is_integral<K>::value, "SetAlgebra: integer keys only");
+
+  private:
+    // Open addressing table of the keys of one partition; a zero mask marks
+    // an empty slot
+    struct Partition {
+        vector<K> keys;
+        vector<uint8_t> masks;
+        uint64_t count = 0;
+
+        Partition() : keys(16), masks(16, 0) {}
+
+        void mark(K key, uint64_t hash, uint8_t input, const Hash &hasher) {
+            if (count + 1 > SET_MAX_LOAD * keys.size())
+                grow(hasher);
+            size_t slot = findSlot(key, hash);
+            if (masks[slot] == 0) {
+                keys[slot] = key;
+                count++;
+            }
+            masks[slot] |= input;
+        }
+
+        size_t findSlot(K key, uint64_t hash) const {
+            size_t mask = keys.size() - 1;
+            size_t slot = hash & mask;
+            while (masks[slot] != 0 && keys[slot] != key)
+                slot = (slot + 1) & mask;
+            return slot;
+        }
+
+        void grow(const Hash &hasher) {
+            vector<K> oldKeys(2 * keys.size());
+            vector<uint8_t> oldMasks(2 * masks.size(), 0);
+            keys.swap(oldKeys);
+            masks.swap(oldMasks);
+            for (size_t i = 0; i < oldKeys.size(); i++) {
+                if (oldMasks[i] == 0)
+                    continue;
+                size_t slot = findSlot(oldKeys[i], hasher(oldKeys[i]));
+                keys[slot] = oldKeys[i];
+                masks[slot] = oldMasks[i];
+            }
+        }
+    };
+
+    vector<Partition> partitions;
+    int threads;
+    Hash hasher;
+    vector<K> staged; // Batch scattered by partition
+
+    // Partition from the high bits, slot in it from the low ones
+    static int partitionOf(uint64_t hash) { return hash >> 56; }
+
+    void add(const K *keys, size_t n, uint8_t input) {
+        if (threads == 1 || n < SET_BLOCK) {
+            for (size_t i = 0; i < n; i++) {
+                uint64_t h = hasher(keys[i]);
+                partitions[partitionOf(h)].mark(keys[i], h, input, hasher);
+            }
+            return;
+        }
+
+        // Per block counts, then each block scatters into its own range of
+        // every partition
+        uint64_t blocks = (n + SET_BLOCK - 1) / SET_BLOCK;
+        vector<uint64_t> start(blocks * SET_PARTITIONS, 0);
+        parallelFor(blocks, threads, [&](uint64_t b) {
+            size_t end = min(n, (size_t)(b + 1) * SET_BLOCK);
+            for (size_t i = b * SET_BLOCK; i < end; i++)
+                start[b * SET_PARTITIONS + partitionOf(hasher(keys[i]))]++;
+        });
+        vector<uint64_t> partitionStart(SET_PARTITIONS + 1, 0);
+        uint64_t running = 0;
+        for (int p = 0; p < SET_PARTITIONS; p++) {
+            partitionStart[p] = running;
+            for (uint64_t b = 0; b < blocks; b++) {
+                uint64_t c = start[b * SET_PARTITIONS + p];
+                start[b * SET_PARTITIONS + p] = running;
+                running += c;
+            }
+        }
+        partitionStart[SET_PARTITIONS] = running;
+        staged.resize(n);
+        parallelFor(blocks, threads, [&](uint64_t b) {
+            size_t end = min(n, (size_t)(b + 1) * SET_BLOCK);
+            for (size_t i = b * SET_BLOCK; i < end; i++) {
+                int p = partitionOf(hasher(keys[i]));
+                staged[start[b * SET_PARTITIONS + p]++] = keys[i];
+            }
+        });
+
+        parallelFor(SET_PARTITIONS, threads, [&](uint64_t p) {
+            for (uint64_t i = partitionStart[p]; i < partitionStart[p + 1];
+                 i++) {
+                uint64_t h = hasher(staged[i]);
+                partitions[p].mark(staged[i], h, input, hasher);
+            }
+        });
+    }
+
+  public:
+    explicit SetAlgebra(int threadCount = 0, const Hash &hash = Hash())
+        : partitions(SET_PARTITIONS), threads(workloadThreads(threadCount)),
+          hasher(hash) {}
+
+    // Streams in the next batch of either input; repeated keys are fine
+    void addA(const K *keys, size_t n) { add(keys, n, SET_A); }
+    void addB(const K *keys, size_t n) { add(keys, n, SET_B); }
+    void addA(const vector<K> &keys) { addA(keys.data(), keys.size()); }
+    void addB(const vector<K> &keys) { addB(keys.data(), keys.size()); }
+
+    // Sizes of the inputs and results without building any of them
+    SetCardinalities cardinalities() const {
+        vector<SetCardinalities> counts(SET_PARTITIONS);
+        parallelFor(SET_PARTITIONS, threads, [&](uint64_t p) {
+            SetCardinalities &c = counts[p];
+            for (uint8_t m : partitions[p].masks) {
+                c.a += (m & SET_A) != 0;
+                c.b += (m & SET_B) != 0;
+                c.intersection += m == (SET_A | SET_B);
+                c.difference += m == SET_A;
+            }
+            c.unionSize = partitions[p].count;
+        });
+        SetCardinalities total;
+        for (const SetCardinalities &c : counts) {
+            total.a += c.a;
+            total.b += c.b;
+            total.unionSize += c.unionSize;
+            total.intersection += c.intersection;
+            total.difference += c.difference;
+        }
+        return total;
+    }
+
+    // All three results, in ascending order unless sorted is false. The
+    // partitions are counted first so every one writes straight to its
+    // place in the outputs.
+    SetResults<K> results(bool sorted = true) const {
+        vector<SetCardinalities> counts(SET_PARTITIONS + 1);
+        parallelFor(SET_PARTITIONS, threads, [&](uint64_t p) {
+            for (uint8_t m : partitions[p].masks) {
+                counts[p + 1].intersection += m == (SET_A | SET_B);
+                counts[p + 1].difference += m == SET_A;
+            }
+            counts[p + 1].unionSize = partitions[p].count;
+        });
+        for (int p = 1; p <= SET_PARTITIONS; p++) {
+            counts[p].unionSize += counts[p - 1].unionSize;
+            counts[p].intersection += counts[p - 1].intersection;
+            counts[p].difference += counts[p - 1].difference;
+        }
+
+        SetResults<K> r;
+        r.unionKeys.resize(counts[SET_PARTITIONS].unionSize);
+        r.intersection.resize(counts[SET_PARTITIONS].intersection);
+        r.difference.resize(counts[SET_PARTITIONS].difference);
+        parallelFor(SET_PARTITIONS, threads, [&](uint64_t p) {
+            const Partition &part = partitions[p];
+            SetCardinalities next = counts[p];
+            for (size_t i = 0; i < part.keys.size(); i++) {
+                uint8_t m = part.masks[i];
+                if (m == 0)
+                    continue;
+                r.unionKeys[next.unionSize++] = part.keys[i];
+                if (m == (SET_A | SET_B))
+                    r.intersection[next.intersection++] = part.keys[i];
+                else if (m == SET_A)
+                    r.difference[next.difference++] = part.keys[i];
+            }
+        });
+
+        if (sorted) {
+            radixSort(r.unionKeys, threads);
+            radixSort(r.intersection, threads);
+            radixSort(r.difference, threads);
+        }
+        return r;
+    }
+
+    uint64_t distinctKeys() const {
+        uint64_t total = 0;
+        for (const Partition &p : partitions)
+            total += p.count;
+        return total;
+    }
+
+    void clear() {
+        vector<Partition>(SET_PARTITIONS).swap(partitions);
+        vector<K>().swap(staged);
+    }
+};
+
+#endif // SETOPERATIONS_H
@@ -0,0 +1,214 @@
+#ifndef SHARDEDHASHTABLE_H
+#define SHARDEDHASHTABLE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "HashTable.h"
+
+using namespace std;
+
+const int DEFAULT_SHARD_COUNT = 64;
+
+// Thread-safe hash table: 2^k independent HashTable shards, each behind its
+// own reader-writer lock. A key's shard is chosen by the high bits of its
+// hash, so operations on different shards never wait for each other, and
+// every shard grows, shrinks and migrates on its own.
+//
+// Readers take the shard lock shared and use HashTable::find, which does not
+// write to the shard. Statistics are kept per thread instead of per shard, so
+// that concurrent readers of one shard do not write to a shared cache line.
+template <typename K, typename V, typename Hash = KeyHash<K>,
+          typename KeyEqual = equal_to<K>>
+class ShardedHashTable {
+  private:
+    typedef HashTable<K, V, Hash, KeyEqual> Table;
+
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        mutable shared_mutex lock;
+        Table table;
+
+        Shard(CollisionMethod m, int hashType, bool incremental,
+              SizePolicy sizes, const Hash &hash, const KeyEqual &equal)
+            : table(m, hashType, incremental, sizes, hash, equal) {}
+    };
+
+    // Counters of one thread, on a cache line of their own. A thread only
+    // ever updates its own slot; relaxed atomics keep the rare slot shared
+    // by two threads (more than COUNTER_SLOTS threads) correct.
+    struct alignas(CACHE_LINE_SIZE) ThreadCounters {
+        atomic<long long> searches{0};
+        atomic<long long> hits{0};
+        atomic<long long> probes{0};
+        atomic<long long> inserts{0};
+        atomic<long long> removes{0};
+    };
+    static const int COUNTER_SLOTS = 64;
+
+    vector<unique_ptr<Shard>> shards;
+    int shardBits;
+    Hash hasher;
+    mutable ThreadCounters counters[COUNTER_SLOTS];
+
+    // Fibonacci hashing: the multiply mixes every bit of the hash into the
+    // top bits, so the shard does not depend on how well the table hash
+    // fills its high bits (the string rolling hashes do not)
+    int shardOf(uint64_t hash) const {
+        if (shardBits == 0)
+            return 0;
+        return (int)((hash * 0x9E3779B97F4A7C15ULL) >> (64 - shardBits));
+    }
+
+    static int threadSlot() {
+        static atomic<int> nextSlot{0};
+        thread_local int slot = nextSlot.fetch_add(1) % COUNTER_SLOTS;
+        return slot;
+    }
+
+    static void add(atomic<long long> &counter, long long n) {
+        counter.fetch_add(n, memory_order_relaxed);
+    }
+
+  public:
+    struct Statistics {
+        long long searches = 0;
+        long long hits = 0;
+        long long probes = 0;
+        long long inserts = 0; // Successful inserts
+        long long removes = 0; // Successful removes
+    };
+
+    // shardCount is rounded up to a power of two. A blocking resize only
+    // rehashes one shard, so it is the default: with incremental resizing
+    // the migration advances only on writes (readers must not modify a
+    // shard), and read-mostly shards would stay half-migrated, making
+    // misses probe both generations.
+    ShardedHashTable(CollisionMethod m, int hashType,
+                     int shardCount = DEFAULT_SHARD_COUNT,
+                     bool incremental = false, SizePolicy sizes = PRIME_SIZES,
+                     const Hash &hash = Hash(),
+                     const KeyEqual &equal = KeyEqual())
+        : shardBits(0), hasher(hash) {
+        if (shardCount < 1)
+            throw invalid_argument("ShardedHashTable: shardCount < 1");
+        while ((1 << shardBits) < shardCount)
+            shardBits++;
+        for (int i = 0; i < (1 << shardBits); i++)
+            shards.emplace_back(
+                new Shard(m, hashType, incremental, sizes, hash, equal));
+    }
+
+    bool insert(const K &key, const V &value) {
+        uint64_t hash = hasher(key);
+        Shard &shard = *shards[shardOf(hash)];
+        bool inserted;
+        {
+            unique_lock<shared_mutex> guard(shard.lock);
+            inserted = shard.table.insert(key, value, hash);
+        }
+        if (inserted)
+            add(counters[threadSlot()].inserts, 1);
+        return inserted;
+    }
+
+    bool search(const K &key, V &value) const {
+        uint64_t hash = hasher(key);
+        const Shard &shard = *shards[shardOf(hash)];
+        int probes = 0;
+        bool found;
+        {
+            shared_lock<shared_mutex> guard(shard.lock);
+            found = shard.table.find(key, value, hash, probes);
+        }
+        ThreadCounters &c = counters[threadSlot()];
+        add(c.searches, 1);
+        add(c.probes, probes);
+        if (found)
+            add(c.hits, 1);
+        return found;
+    }
+
+    bool remove(const K &key) {
+        uint64_t hash = hasher(key);
+        Shard &shard = *shards[shardOf(hash)];
+        bool removed;
+        {
+            unique_lock<shared_mutex> guard(shard.lock);
+            removed = shard.table.remove(key, hash);
+        }
+        if (removed)
+            add(counters[threadSlot()].removes, 1);
+        return removed;
+    }
+
+    int getShardCount() const { return (int)shards.size(); }
+
+    // Number of keys; each shard is locked in turn, so the total is only
+    // exact while no writer is running
+    long long getSize() const {
+        long long total = 0;
+        for (auto &shard : shards) {
+            shared_lock<shared_mutex> guard(shard->lock);
+            total += shard->table.getSize();
+        }
+        return total;
+    }
+
+    long long getCollisions() const {
+        long long total = 0;
+        for (auto &shard : shards) {
+            shared_lock<shared_mutex> guard(shard->lock);
+            total += shard->table.getCollisions();
+        }
+        return total;
+    }
+
+    // Sum over all threads' counters
+    Statistics getStatistics() const {
+        Statistics s;
+        for (const ThreadCounters &c : counters) {
+            s.searches += c.searches.load(memory_order_relaxed);
+            s.hits += c.hits.load(memory_order_relaxed);
+            s.probes += c.probes.load(memory_order_relaxed);
+            s.inserts += c.inserts.load(memory_order_relaxed);
+            s.removes += c.removes.load(memory_order_relaxed);
+        }
+        return s;
+    }
+
+    double getAverageProbes() const {
+        Statistics s = getStatistics();
+        return s.searches > 0 ? (double)s.probes / s.searches : 0.0;
+    }
+
+    // TableStats snapshots of all shards combined; each shard is locked
+    // shared while its snapshot is taken
+    StatsSnapshot getStatsSnapshot() const {
+        StatsSnapshot s;
+        for (auto &shard : shards) {
+            shared_lock<shared_mutex> guard(shard->lock);
+            s.merge(shard->table.getStatsSnapshot());
+        }
+        return s;
+    }
+
+    void resetStatistics() {
+        for (ThreadCounters &c : counters) {
+            c.searches = 0;
+            c.hits = 0;
+            c.probes = 0;
+            c.inserts = 0;
+            c.removes = 0;
+        }
+        for (auto &shard : shards) {
+            unique_lock<shared_mutex> guard(shard->lock);
+            shard->table.resetStatistics();
+        }
+    }
+};
+
+#endif // SHARDEDHASHTABLE_H
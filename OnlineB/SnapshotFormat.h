@@ -0,0 +1,184 @@
+#ifndef SNAPSHOTFORMAT_H
+#define SNAPSHOTFORMAT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// On-disk layout of a HashTable snapshot, written by HashTable::saveSnapshot
+// and mapped back by MappedHashTable. Every reference inside the file is an
+// offset, so the file can be mapped at any address and used in place:
+//
+//   SnapshotHeader
+//   control bytes       GROUP_PROBING: capacity + GROUP_WIDTH - 1 bytes
+//                       CUCKOO_HASHING: capacity bytes
+//   bucket starts       CHAINING: capacity + 1 indices into the slots
+//   slots               SnapshotSlot<V>: one per bucket (open addressing) or
+//                       one per key, grouped by bucket (chaining); the
+//                       cuckoo stash follows the capacity slots
+//   key arena           key bytes, referenced by the slots
+//
+// Sections start on SNAPSHOT_ALIGNMENT boundaries. Numbers are in the byte
+// order of the machine that wrote the file.
+
+const char SNAPSHOT_MAGIC[8] = {'H', 'T', 'S', 'N', 'A', 'P', '0', '1'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint64_t SNAPSHOT_ALIGNMENT = 64;
+// Stored keys whose hash is recomputed when a snapshot is opened, to catch a
+// Hash functor other than the one that built the table
+const int SNAPSHOT_HASH_CHECKS = 64;
+
+enum SnapshotSlotState : uint32_t {
+    SNAPSHOT_EMPTY,
+    SNAPSHOT_FULL,
+    SNAPSHOT_DELETED
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t method;          // CollisionMethod
+    int32_t hashFunctionType; // 1 or 2
+    int32_t c1, c2;           // Custom probing constants
+    uint32_t keySize;         // sizeof(K), 0 for string keys
+    uint32_t valueSize;       // sizeof(V)
+    uint32_t slotSize;        // sizeof(SnapshotSlot<V>)
+    uint64_t capacity;        // Buckets
+    uint64_t elements;
+    uint64_t tombstones;
+    uint64_t ctrlOffset, ctrlBytes;
+    uint64_t bucketsOffset, bucketCount;
+    uint64_t slotsOffset, slotCount;
+    uint64_t arenaOffset, arenaBytes;
+    uint64_t fileSize;
+};
+
+template <typename V> struct SnapshotSlot {
+    uint32_t primary; // HashPair of the key
+    uint32_t aux;
+    uint64_t keyOffset; // Into the key arena
+    uint32_t keyLength;
+    uint32_t state; // SnapshotSlotState
+    V value;
+};
+
+// Bytes of a key as stored in the arena: the characters of a string, the
+// object representation of anything trivially copyable (integers,
+// FixedString)
+inline string_view snapshotKeyBytes(const string &key) { return key; }
+
+template <typename K> string_view snapshotKeyBytes(const K &key) {
+    static_assert(is_trivially_copyable<K>::value,
+                  "snapshot keys must be strings or trivially copyable");
+    return string_view((const char *)&key, sizeof(K));
+}
+
+template <typename K> struct SnapshotKeyCodec {
+    static const uint32_t SIZE = sizeof(K);
+    static K decode(string_view bytes) {
+        K key;
+        memcpy((void *)&key, bytes.data(), sizeof(K));
+        return key;
+    }
+};
+
+template <> struct SnapshotKeyCodec<string> {
+    static const uint32_t SIZE = 0;
+    static string decode(string_view bytes) { return string(bytes); }
+};
+
+inline uint64_t snapshotAlign(uint64_t pos) {
+    return (pos + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1);
+}
+
+// Lays out the sections, fills in their offsets in header and writes the
+// file. Throws runtime_error on I/O errors.
+inline void writeSnapshotFile(const string &path, SnapshotHeader &header,
+                              const void *ctrl, const void *buckets,
+                              const void *slots, const string &arena) {
+    uint64_t pos = snapshotAlign(sizeof(SnapshotHeader));
+    header.ctrlOffset = pos;
+    pos = snapshotAlign(pos + header.ctrlBytes);
+    header.bucketsOffset = pos;
+    pos = snapshotAlign(pos + header.bucketCount * sizeof(uint64_t));
+    header.slotsOffset = pos;
+    pos = snapshotAlign(pos + header.slotCount * header.slotSize);
+    header.arenaOffset = pos;
+    header.arenaBytes = arena.size();
+    header.fileSize = pos + arena.size();
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        throw runtime_error("snapshot: cannot create " + path);
+    uint64_t written = 0;
+    bool ok = true;
+    auto put = [&](uint64_t offset, const void *data, uint64_t bytes) {
+        static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+        while (ok && written < offset) {
+            uint64_t n = min<uint64_t>(offset - written, sizeof(zeros));
+            ok = fwrite(zeros, 1, n, file) == n;
+            written += n;
+        }
+        if (ok && bytes > 0)
+            ok = fwrite(data, 1, bytes, file) == bytes;
+        written += bytes;
+    };
+    put(0, &header, sizeof(header));
+    put(header.ctrlOffset, ctrl, header.ctrlBytes);
+    put(header.bucketsOffset, buckets, header.bucketCount * sizeof(uint64_t));
+    put(header.slotsOffset, slots, header.slotCount * header.slotSize);
+    put(header.arenaOffset, arena.data(), arena.size());
+    if (fclose(file) != 0 || !ok)
+        throw runtime_error("snapshot: cannot write " + path);
+}
+
+// A whole file mapped into memory. Read-only mappings share the page cache;
+// copy-on-write mappings may be written, and the first write to a page gives
+// this process a private copy of it - the file never changes.
+class MappedFile {
+  private:
+    char *data;
+    size_t length;
+
+  public:
+    MappedFile(const string &path, bool copyOnWrite)
+        : data(nullptr), length(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw runtime_error("snapshot: cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw runtime_error("snapshot: cannot read " + path);
+        }
+        length = st.st_size;
+        void *p = mmap(nullptr, length,
+                       copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ,
+                       copyOnWrite ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+        close(fd); // The mapping keeps the file open
+        if (p == MAP_FAILED)
+            throw runtime_error("snapshot: cannot map " + path);
+        data = (char *)p;
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() { munmap(data, length); }
+
+    char *bytes() const { return data; }
+    size_t size() const { return length; }
+};
+
+#endif // SNAPSHOTFORMAT_H
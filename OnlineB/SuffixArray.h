@@ -0,0 +1,196 @@
+#ifndef SUFFIXARRAY_H
+#define SUFFIXARRAY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Suffix array of a byte string by SA-IS (Nong, Zhang and Chan, "Two
+// efficient algorithms for linear time suffix array construction"), the
+// LCP array by Kasai's algorithm, and the number of distinct substrings
+// from the two. Everything is linear in time and memory, at most about 16
+// bytes per input byte at the peak, for any byte values including '\0'.
+//
+// Suffixes are indexed by int, so inputs are limited to INT_MAX - 1 bytes.
+
+// Sorts the suffixes of s[0..n), whose symbols are in [0, upper], into sa.
+// A suffix is S-type if it is smaller than the next one and L-type if
+// larger; the LMS suffixes (S-type after an L-type) are sorted first, by
+// recursing on the string of their substrings' ranks when those are not
+// all different, and every other suffix is induced from them.
+template <typename C>
+void saIs(const C *s, int n, int upper, int *sa) {
+    if (n == 0)
+        return;
+    if (n == 1) {
+        sa[0] = 0;
+        return;
+    }
+    if (n == 2) {
+        bool inOrder = s[0] < s[1];
+        sa[0] = inOrder ? 0 : 1;
+        sa[1] = inOrder ? 1 : 0;
+        return;
+    }
+
+    vector<uint8_t> sType(n, 0);
+    for (int i = n - 2; i >= 0; i--)
+        sType[i] = (s[i] == s[i + 1]) ? sType[i + 1] : s[i] < s[i + 1];
+    auto isLms = [&](int i) { return i > 0 && sType[i] && !sType[i - 1]; };
+
+    // Bucket of symbol c: L-type suffixes from lStart[c], S-type ones from
+    // sStart[c] (L before S: an L-type suffix is smaller)
+    vector<int> lStart(upper + 2, 0), sStart(upper + 2, 0);
+    for (int i = 0; i < n; i++) {
+        if (sType[i])
+            lStart[(int)s[i] + 1]++;
+        else
+            sStart[s[i]]++;
+    }
+    for (int c = 0; c <= upper; c++) {
+        sStart[c] += lStart[c];
+        lStart[c + 1] += sStart[c];
+    }
+
+    // LMS suffixes in the given order into the S ends of their buckets,
+    // then L-type suffixes left to right and S-type ones right to left
+    vector<int> next(upper + 2);
+    auto induce = [&](const vector<int> &lms) {
+        fill(sa, sa + n, -1);
+        next.assign(sStart.begin(), sStart.end());
+        for (int p : lms)
+            sa[next[s[p]]++] = p;
+        next.assign(lStart.begin(), lStart.end());
+        sa[next[s[n - 1]]++] = n - 1;
+        for (int i = 0; i < n; i++) {
+            int p = sa[i] - 1;
+            if (p >= 0 && !sType[p])
+                sa[next[s[p]]++] = p;
+        }
+        next.assign(lStart.begin(), lStart.end());
+        for (int i = n - 1; i >= 0; i--) {
+            int p = sa[i] - 1;
+            if (p >= 0 && sType[p])
+                sa[--next[(int)s[p] + 1]] = p;
+        }
+    };
+
+    vector<int> lmsIndex(n, -1);
+    vector<int> lms;
+    for (int i = 1; i < n; i++)
+        if (isLms(i)) {
+            lmsIndex[i] = lms.size();
+            lms.push_back(i);
+        }
+    induce(lms);
+    if (lms.empty())
+        return;
+
+    // The induced order is right for the LMS substrings; rank them, equal
+    // substrings equally
+    vector<int> sorted;
+    sorted.reserve(lms.size());
+    for (int i = 0; i < n; i++)
+        if (lmsIndex[sa[i]] != -1)
+            sorted.push_back(sa[i]);
+    int m = lms.size();
+    vector<int> reduced(m);
+    int rank = 0;
+    reduced[lmsIndex[sorted[0]]] = 0;
+    for (int i = 1; i < m; i++) {
+        int a = sorted[i - 1], b = sorted[i];
+        int endA = (lmsIndex[a] + 1 < m) ? lms[lmsIndex[a] + 1] : n;
+        int endB = (lmsIndex[b] + 1 < m) ? lms[lmsIndex[b] + 1] : n;
+        bool same = endA - a == endB - b;
+        if (same) {
+            while (a < endA && s[a] == s[b]) {
+                a++;
+                b++;
+            }
+            same = a < n && s[a] == s[b];
+        }
+        if (!same)
+            rank++;
+        reduced[lmsIndex[sorted[i]]] = rank;
+    }
+    vector<int>().swap(lmsIndex);
+
+    if (rank + 1 < m) {
+        vector<int> reducedSa(m);
+        saIs(reduced.data(), m, rank, reducedSa.data());
+        for (int i = 0; i < m; i++)
+            sorted[i] = lms[reducedSa[i]];
+    }
+    induce(sorted);
+}
+
+inline void checkSuffixLength(size_t n) {
+    if (n >= (size_t)numeric_limits<int>::max())
+        throw length_error("suffix array: input too long");
+}
+
+// Start of the i-th smallest suffix of s
+inline vector<int> suffixArray(string_view s) {
+    checkSuffixLength(s.size());
+    vector<int> sa(s.size());
+    saIs((const uint8_t *)s.data(), s.size(), 255, sa.data());
+    return sa;
+}
+
+// lcp[i]: length of the longest common prefix of the suffixes sa[i] and
+// sa[i + 1] (n - 1 entries). Kasai et al.: walking the suffixes in text
+// order, the next one's LCP drops by at most 1.
+inline vector<int> lcpArray(string_view s, const vector<int> &sa) {
+    int n = s.size();
+    if (n == 0)
+        return {};
+    vector<int> rank(n);
+    for (int i = 0; i < n; i++)
+        rank[sa[i]] = i;
+    vector<int> lcp(n - 1);
+    int h = 0;
+    for (int i = 0; i < n; i++) {
+        if (h > 0)
+            h--;
+        if (rank[i] == 0)
+            continue;
+        int j = sa[rank[i] - 1];
+        while (i + h < n && j + h < n && s[i + h] == s[j + h])
+            h++;
+        lcp[rank[i] - 1] = h;
+    }
+    return lcp;
+}
+
+// Distinct non-empty substrings: every prefix of every suffix, less those
+// shared with the previous suffix in sorted order. Kasai's walk without
+// storing the LCP array, reusing the suffix array for the ranks.
+inline uint64_t countDistinctSubstrings(string_view s) {
+    int n = s.size();
+    vector<int> sa = suffixArray(s);
+    vector<int> previous(n, -1); // Suffix before i in sorted order
+    for (int i = 1; i < n; i++)
+        previous[sa[i]] = sa[i - 1];
+    vector<int>().swap(sa);
+
+    uint64_t count = (uint64_t)n * (n + 1) / 2;
+    int h = 0;
+    for (int i = 0; i < n; i++) {
+        if (h > 0)
+            h--;
+        int j = previous[i];
+        if (j < 0)
+            continue;
+        while (i + h < n && j + h < n && s[i + h] == s[j + h])
+            h++;
+        count -= h;
+    }
+    return count;
+}
+
+#endif // SUFFIXARRAY_H
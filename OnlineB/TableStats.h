@@ -0,0 +1,297 @@
+#ifndef TABLESTATS_H
+#define TABLESTATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+// Detailed HashTable instrumentation. The per-operation counters (probe
+// lengths of hits and misses, resizes) are only compiled in with
+// -DHASHTABLE_STATS; without it every hook below is an empty inline function.
+// The structural statistics of a snapshot (clusters, chains, tombstones) are
+// computed by walking the table when the snapshot is taken, so they cost
+// nothing per operation and are always available.
+
+// Lengths 0..62 are counted exactly, longer ones in the last bucket
+const int LENGTH_HISTOGRAM_BUCKETS = 64;
+
+struct LengthHistogram {
+    long long counts[LENGTH_HISTOGRAM_BUCKETS];
+    long long total; // Number of samples
+    long long sum;   // Sum of the lengths
+    int max;
+
+    LengthHistogram() { clear(); }
+
+    void clear() {
+        fill(counts, counts + LENGTH_HISTOGRAM_BUCKETS, 0LL);
+        total = 0;
+        sum = 0;
+        max = 0;
+    }
+
+    static int bucketOf(int length) {
+        return min(length, LENGTH_HISTOGRAM_BUCKETS - 1);
+    }
+
+    void add(int length, long long times = 1) {
+        counts[bucketOf(length)] += times;
+        total += times;
+        sum += (long long)length * times;
+        max = std::max(max, length);
+    }
+
+    void merge(const LengthHistogram &o) {
+        for (int i = 0; i < LENGTH_HISTOGRAM_BUCKETS; i++)
+            counts[i] += o.counts[i];
+        total += o.total;
+        sum += o.sum;
+        max = std::max(max, o.max);
+    }
+
+    double mean() const { return total > 0 ? (double)sum / total : 0.0; }
+
+    // Smallest length that at least fraction q of the samples do not exceed
+    // (max for the overflow bucket)
+    int percentile(double q) const {
+        long long seen = 0;
+        for (int i = 0; i < LENGTH_HISTOGRAM_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > 0 && seen >= q * total)
+                return i == LENGTH_HISTOGRAM_BUCKETS - 1 ? max : i;
+        }
+        return max;
+    }
+
+    void print(ostream &out, const char *name) const {
+        out << name << ": n=" << total << fixed << setprecision(2)
+            << " mean=" << mean() << " p50=" << percentile(0.5)
+            << " p90=" << percentile(0.9) << " p99=" << percentile(0.99)
+            << " max=" << max << endl;
+        for (int i = 0; i < LENGTH_HISTOGRAM_BUCKETS; i++)
+            if (counts[i] > 0)
+                out << "  " << setw(4) << i
+                    << (i == LENGTH_HISTOGRAM_BUCKETS - 1 ? "+" : " ")
+                    << setw(12) << counts[i] << endl;
+    }
+};
+
+// Point-in-time view of a table's statistics
+struct StatsSnapshot {
+    bool counting = false; // Built with HASHTABLE_STATS
+
+    // Per lookup (search, searchBatch, find); needs HASHTABLE_STATS
+    LengthHistogram hitProbes;
+    LengthHistogram missProbes;
+    long long resizes = 0;
+    double resizeSeconds = 0;      // Blocking rehashes and migration steps
+    double longestResizePause = 0; // Longest single one of those
+
+    // Structure when the snapshot was taken
+    long long size = 0;
+    long long capacity = 0;
+    long long tombstones = 0;
+    long long failedInserts = 0; // No free slot within the probe limit
+    LengthHistogram clusterLengths; // Runs of non-empty slots (probing)
+    LengthHistogram chainLengths;   // Nodes per non-empty bucket (chaining)
+
+    int maxProbeLength() const { return max(hitProbes.max, missProbes.max); }
+
+    // Combines the snapshots of independent tables (e.g. shards)
+    void merge(const StatsSnapshot &o) {
+        counting = counting || o.counting;
+        hitProbes.merge(o.hitProbes);
+        missProbes.merge(o.missProbes);
+        resizes += o.resizes;
+        resizeSeconds += o.resizeSeconds;
+        longestResizePause = max(longestResizePause, o.longestResizePause);
+        size += o.size;
+        capacity += o.capacity;
+        tombstones += o.tombstones;
+        failedInserts += o.failedInserts;
+        clusterLengths.merge(o.clusterLengths);
+        chainLengths.merge(o.chainLengths);
+    }
+
+    void print(ostream &out) const {
+        out << "size " << size << ", capacity " << capacity << ", tombstones "
+            << tombstones << ", failed inserts " << failedInserts << endl;
+        if (counting) {
+            hitProbes.print(out, "hit probes");
+            missProbes.print(out, "miss probes");
+            out << "resizes " << resizes << ", " << fixed << setprecision(3)
+                << resizeSeconds * 1e3 << " ms total, longest pause "
+                << longestResizePause * 1e3 << " ms" << endl;
+        } else {
+            out << "(probe and resize counters need -DHASHTABLE_STATS)"
+                << endl;
+        }
+        if (clusterLengths.total > 0)
+            clusterLengths.print(out, "cluster lengths");
+        if (chainLengths.total > 0)
+            chainLengths.print(out, "chain lengths");
+    }
+};
+
+#ifdef HASHTABLE_STATS
+
+typedef chrono::steady_clock::time_point StatsTimer;
+
+// Per-operation counters of one table. Every thread updates a counter block
+// of its own (allocated on first use, on a cache line of its own), so
+// concurrent readers of one table - see ShardedHashTable - never write to a
+// shared line. Relaxed atomics keep the rare block shared by two threads
+// (more than STATS_THREAD_SLOTS threads) correct.
+class TableStats {
+  private:
+    static const int STATS_THREAD_SLOTS = 64;
+
+    struct AtomicHistogram {
+        atomic<long long> counts[LENGTH_HISTOGRAM_BUCKETS];
+        atomic<long long> sum;
+        atomic<int> max;
+
+        AtomicHistogram() : sum(0), max(0) {
+            for (auto &c : counts)
+                c.store(0, memory_order_relaxed);
+        }
+
+        void add(int length) {
+            counts[LengthHistogram::bucketOf(length)].fetch_add(
+                1, memory_order_relaxed);
+            sum.fetch_add(length, memory_order_relaxed);
+            int m = max.load(memory_order_relaxed);
+            while (length > m &&
+                   !max.compare_exchange_weak(m, length, memory_order_relaxed))
+                ;
+        }
+
+        void addTo(LengthHistogram &h) const {
+            for (int i = 0; i < LENGTH_HISTOGRAM_BUCKETS; i++) {
+                long long c = counts[i].load(memory_order_relaxed);
+                h.counts[i] += c;
+                h.total += c;
+            }
+            h.sum += sum.load(memory_order_relaxed);
+            h.max = std::max(h.max, max.load(memory_order_relaxed));
+        }
+    };
+
+    struct alignas(64) Counters {
+        AtomicHistogram hits;
+        AtomicHistogram misses;
+        atomic<long long> resizes{0};
+        atomic<long long> resizeNanos{0};
+        atomic<long long> longestPauseNanos{0};
+    };
+
+    mutable atomic<Counters *> slots[STATS_THREAD_SLOTS];
+
+    static int threadSlot() {
+        static atomic<int> nextSlot{0};
+        thread_local int slot = nextSlot.fetch_add(1) % STATS_THREAD_SLOTS;
+        return slot;
+    }
+
+    Counters &local() const {
+        atomic<Counters *> &slot = slots[threadSlot()];
+        Counters *c = slot.load(memory_order_acquire);
+        if (c == nullptr) {
+            Counters *fresh = new Counters();
+            if (slot.compare_exchange_strong(c, fresh, memory_order_acq_rel))
+                c = fresh;
+            else
+                delete fresh; // Another thread of this slot was first
+        }
+        return *c;
+    }
+
+    void addPause(StatsTimer start) {
+        long long ns = chrono::duration_cast<chrono::nanoseconds>(
+                           chrono::steady_clock::now() - start)
+                           .count();
+        Counters &c = local();
+        c.resizeNanos.fetch_add(ns, memory_order_relaxed);
+        if (ns > c.longestPauseNanos.load(memory_order_relaxed))
+            c.longestPauseNanos.store(ns, memory_order_relaxed);
+    }
+
+    void clear() {
+        for (auto &slot : slots) {
+            delete slot.load(memory_order_relaxed);
+            slot.store(nullptr, memory_order_relaxed);
+        }
+    }
+
+  public:
+    TableStats() {
+        for (auto &slot : slots)
+            slot.store(nullptr, memory_order_relaxed);
+    }
+    // Statistics belong to one table object: a copy starts from zero
+    TableStats(const TableStats &) : TableStats() {}
+    TableStats &operator=(const TableStats &) { return *this; }
+    ~TableStats() { clear(); }
+
+    void recordLookup(bool found, int probes) const {
+        Counters &c = local();
+        (found ? c.hits : c.misses).add(probes);
+    }
+
+    StatsTimer startTimer() const { return chrono::steady_clock::now(); }
+
+    // A resize: a rehash into a new generation, timed up to the end of its
+    // blocking migration
+    void recordResize(StatsTimer start) {
+        local().resizes.fetch_add(1, memory_order_relaxed);
+        addPause(start);
+    }
+
+    // Part of an incremental migration, done by an ordinary operation
+    void recordMigrationStep(StatsTimer start) { addPause(start); }
+
+    // Must not run concurrently with operations on the table
+    void reset() { clear(); }
+
+    StatsSnapshot snapshot() const {
+        StatsSnapshot s;
+        s.counting = true;
+        long long nanos = 0, longest = 0;
+        for (auto &slot : slots) {
+            Counters *c = slot.load(memory_order_acquire);
+            if (c == nullptr)
+                continue;
+            c->hits.addTo(s.hitProbes);
+            c->misses.addTo(s.missProbes);
+            s.resizes += c->resizes.load(memory_order_relaxed);
+            nanos += c->resizeNanos.load(memory_order_relaxed);
+            longest =
+                max(longest, c->longestPauseNanos.load(memory_order_relaxed));
+        }
+        s.resizeSeconds = nanos / 1e9;
+        s.longestResizePause = longest / 1e9;
+        return s;
+    }
+};
+
+#else
+
+struct StatsTimer {};
+
+class TableStats {
+  public:
+    void recordLookup(bool, int) const {}
+    StatsTimer startTimer() const { return StatsTimer(); }
+    void recordResize(StatsTimer) {}
+    void recordMigrationStep(StatsTimer) {}
+    void reset() {}
+    StatsSnapshot snapshot() const { return StatsSnapshot(); }
+};
+
+#endif // HASHTABLE_STATS
+
+#endif // TABLESTATS_H
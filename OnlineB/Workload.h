@@ -0,0 +1,610 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "HashFunctions.h"
+
+using namespace std;
+
+// Key workloads for the benchmarks and test drivers, shared by OnlineB and
+// OnlineC. Keys are generated in parallel, deduplicated by hash instead of
+// through a set, and can be written to a compact binary file once and
+// streamed back by every run.
+//
+// Generation works on chunks of WORKLOAD_CHUNK keys, each with a seed derived
+// from the workload seed and the chunk number, so the keys only depend on the
+// seed - never on the number of threads.
+
+enum KeyDistribution {
+    UNIFORM_KEYS,    // Random lower-case letters
+    ZIPF_KEYS,       // Stream of draws from a Zipf law over random unique keys
+    SEQUENTIAL_KEYS, // Key i is i written in base 26 ('a' = 0)
+    ADVERSARIAL_KEYS // Random keys that all fall into the same bucket
+};
+
+enum LengthDistribution {
+    FIXED_LENGTH,   // minLength
+    UNIFORM_LENGTH, // minLength..maxLength
+    NORMAL_LENGTH   // Mean in the middle, 3 sigma at the ends, clamped
+};
+
+const int WORKLOAD_CHUNK = 1 << 16;
+const int DEDUP_PARTITIONS = 256;
+// Refill rounds before giving up on a key space that is too small
+const int MAX_DEDUP_ROUNDS = 1000;
+// Lengths are stored in 16 bits
+const int MAX_KEY_LENGTH = 65535;
+
+struct WorkloadSpec {
+    KeyDistribution distribution = UNIFORM_KEYS;
+    uint64_t count = 0;    // Keys (ZIPF_KEYS: draws) to produce
+    uint64_t universe = 0; // ZIPF_KEYS: distinct keys drawn from (0: count)
+    double zipfExponent = 0.99;
+    LengthDistribution lengths = FIXED_LENGTH;
+    int minLength = 10;
+    int maxLength = 10;
+    uint64_t seed = 42;
+    int threads = 0; // 0: one per hardware thread
+    // ADVERSARIAL_KEYS: bucketHash(key) % buckets == targetBucket for every
+    // key. Each key takes about `buckets` attempts.
+    function<uint64_t(const string &)> bucketHash;
+    uint64_t buckets = 0;
+    uint64_t targetBucket = 0;
+};
+
+// splitmix64
+inline uint64_t splitMix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Independent random stream number `stream` of chunk `chunk`
+inline uint64_t chunkSeed(uint64_t seed, uint64_t chunk, uint64_t stream) {
+    uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    state = splitMix64(state) + chunk;
+    return splitMix64(state);
+}
+
+inline double uniformDouble(uint64_t &state) {
+    return (splitMix64(state) >> 11) * 0x1.0p-53;
+}
+
+inline int workloadThreads(int requested) {
+    if (requested > 0)
+        return requested;
+    return max(1u, thread::hardware_concurrency());
+}
+
+// Runs body(0..tasks) on `threads` threads, handing out tasks dynamically
+template <typename F> void parallelFor(uint64_t tasks, int threads, F body) {
+    atomic<uint64_t> next(0);
+    auto worker = [&] {
+        for (uint64_t t; (t = next.fetch_add(1)) < tasks;)
+            body(t);
+    };
+    vector<thread> pool;
+    for (int i = 1; i < threads && (uint64_t)i < tasks; i++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &th : pool)
+        th.join();
+}
+
+// Zipf law over ranks 1..n, P(k) ~ 1 / k^s, by rejection-inversion
+// (Hormann and Derflinger): O(1) per draw and no table of n weights.
+class ZipfSampler {
+  private:
+    uint64_t n;
+    double s;
+    double hIntegralX1, hIntegralN, threshold;
+
+    // (exp(x) - 1) / x and log(1 + x) / x, accurate near 0
+    static double expm1Over(double x) {
+        return fabs(x) > 1e-8 ? expm1(x) / x
+                              : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+    }
+    static double log1pOver(double x) {
+        return fabs(x) > 1e-8 ? log1p(x) / x
+                              : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    double h(double x) const { return exp(-s * log(x)); }
+
+    double hIntegral(double x) const {
+        double logX = log(x);
+        return expm1Over((1 - s) * logX) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = max(-1.0, x * (1 - s));
+        return exp(log1pOver(t) * x);
+    }
+
+  public:
+    ZipfSampler(uint64_t n, double s) : n(n), s(s) {
+        if (n == 0 || s <= 0)
+            throw invalid_argument("ZipfSampler: need n > 0 and s > 0");
+        hIntegralX1 = hIntegral(1.5) - 1;
+        hIntegralN = hIntegral(n + 0.5);
+        threshold = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    // Rank in 1..n; rank 1 is the most frequent
+    uint64_t operator()(uint64_t &state) const {
+        while (true) {
+            double u = hIntegralN + uniformDouble(state) * (hIntegralX1 - hIntegralN);
+            double x = hIntegralInverse(u);
+            double k = floor(x + 0.5);
+            k = min(max(k, 1.0), (double)n);
+            if (k - x <= threshold || u >= hIntegral(k + 0.5) - h(k))
+                return (uint64_t)k;
+        }
+    }
+};
+
+// Keys stored back to back in one buffer, without a string object per key
+class KeyArena {
+  private:
+    vector<char> bytes;
+    vector<uint64_t> offsets; // Key i is bytes[offsets[i], offsets[i + 1])
+
+  public:
+    KeyArena() : offsets(1, 0) {}
+
+    size_t size() const { return offsets.size() - 1; }
+
+    uint64_t byteCount() const { return bytes.size(); }
+
+    string_view view(size_t i) const {
+        return string_view(bytes.data() + offsets[i],
+                           offsets[i + 1] - offsets[i]);
+    }
+
+    string key(size_t i) const { return string(view(i)); }
+
+    // Appends a key of len bytes and returns where to write it
+    char *add(size_t len) {
+        bytes.resize(bytes.size() + len);
+        offsets.push_back(bytes.size());
+        return bytes.data() + bytes.size() - len;
+    }
+
+    void append(const KeyArena &o) {
+        uint64_t base = bytes.size();
+        bytes.insert(bytes.end(), o.bytes.begin(), o.bytes.end());
+        for (size_t i = 1; i < o.offsets.size(); i++)
+            offsets.push_back(base + o.offsets[i]);
+    }
+
+    void truncate(size_t n) {
+        if (n >= size())
+            return;
+        offsets.resize(n + 1);
+        bytes.resize(offsets[n]);
+    }
+
+    // Keeps the keys with keep[i] != 0, in order
+    void compact(const vector<char> &keep) {
+        uint64_t to = 0;
+        size_t kept = 0;
+        for (size_t i = 0; i < size(); i++) {
+            if (!keep[i])
+                continue;
+            uint64_t from = offsets[i], len = offsets[i + 1] - from;
+            memmove(bytes.data() + to, bytes.data() + from, len);
+            offsets[kept] = to;
+            to += len;
+            kept++;
+        }
+        offsets[kept] = to;
+        offsets.resize(kept + 1);
+        bytes.resize(to);
+    }
+
+    vector<string> toStrings() const {
+        vector<string> keys(size());
+        for (size_t i = 0; i < size(); i++)
+            keys[i] = key(i);
+        return keys;
+    }
+};
+
+inline int sampleLength(const WorkloadSpec &spec, uint64_t &state) {
+    if (spec.lengths == UNIFORM_LENGTH)
+        return spec.minLength +
+               (int)(splitMix64(state) % (spec.maxLength - spec.minLength + 1));
+    if (spec.lengths == NORMAL_LENGTH) {
+        // Box-Muller
+        double u1 = 1 - uniformDouble(state), u2 = uniformDouble(state);
+        double z = sqrt(-2 * log(u1)) * cos(2 * 3.14159265358979323846 * u2);
+        double mean = (spec.minLength + spec.maxLength) / 2.0;
+        double sigma = (spec.maxLength - spec.minLength) / 6.0;
+        int len = (int)lround(mean + z * sigma);
+        return min(max(len, spec.minLength), spec.maxLength);
+    }
+    return spec.minLength;
+}
+
+// Uniform letters, eight per random number: each multiply by 26 moves the
+// next base-26 digit into the high word
+inline void randomLetters(char *p, int len, uint64_t &state) {
+    uint64_t r = 0;
+    for (int i = 0; i < len; i++) {
+        if (i % 8 == 0)
+            r = splitMix64(state);
+        __uint128_t m = (__uint128_t)r * 26;
+        p[i] = (char)('a' + (int)(m >> 64));
+        r = (uint64_t)m;
+    }
+}
+
+// Appends the WORKLOAD_CHUNK keys of chunk number `chunk` to out
+inline void generateChunk(const WorkloadSpec &spec, uint64_t chunk,
+                          KeyArena &out) {
+    uint64_t state = chunkSeed(spec.seed, chunk, 0);
+    string candidate;
+    for (int j = 0; j < WORKLOAD_CHUNK; j++) {
+        int len = sampleLength(spec, state);
+        if (spec.distribution == SEQUENTIAL_KEYS) {
+            uint64_t i = chunk * WORKLOAD_CHUNK + j;
+            int digits = 1;
+            for (uint64_t v = i / 26; v > 0; v /= 26)
+                digits++;
+            len = max(len, digits);
+            char *p = out.add(len);
+            for (int d = len - 1; d >= 0; d--, i /= 26)
+                p[d] = (char)('a' + i % 26);
+        } else if (spec.distribution == ADVERSARIAL_KEYS) {
+            candidate.resize(len);
+            do {
+                randomLetters(&candidate[0], len, state);
+            } while (spec.bucketHash(candidate) % spec.buckets !=
+                     spec.targetBucket);
+            memcpy(out.add(len), candidate.data(), len);
+        } else {
+            randomLetters(out.add(len), len, state);
+        }
+    }
+}
+
+// Clears keep[i] for every key whose 64-bit hash equals the hash of an
+// earlier key. Different keys with equal hashes count as duplicates too: the
+// later one is just replaced, and the keys stay unique.
+// Hashes are partitioned on their top byte (stably, so "earlier" holds within
+// a partition) and every partition is checked against its own set.
+inline void markDuplicates(const KeyArena &keys, vector<char> &keep,
+                           int threads) {
+    size_t n = keys.size();
+    vector<uint64_t> hashes(n);
+    uint64_t blocks = (n + WORKLOAD_CHUNK - 1) / WORKLOAD_CHUNK;
+    parallelFor(blocks, threads, [&](uint64_t b) {
+        size_t end = min(n, (size_t)(b + 1) * WORKLOAD_CHUNK);
+        for (size_t i = b * WORKLOAD_CHUNK; i < end; i++) {
+            string_view k = keys.view(i);
+            hashes[i] = wyHash(k.data(), k.size());
+        }
+    });
+
+    // Stable partitioning: per block counts, then each block scatters into
+    // its own range of every partition
+    vector<uint64_t> start(blocks * DEDUP_PARTITIONS, 0);
+    parallelFor(blocks, threads, [&](uint64_t b) {
+        size_t end = min(n, (size_t)(b + 1) * WORKLOAD_CHUNK);
+        for (size_t i = b * WORKLOAD_CHUNK; i < end; i++)
+            start[b * DEDUP_PARTITIONS + (hashes[i] >> 56)]++;
+    });
+    vector<uint64_t> partitionStart(DEDUP_PARTITIONS + 1, 0);
+    uint64_t running = 0;
+    for (int p = 0; p < DEDUP_PARTITIONS; p++) {
+        partitionStart[p] = running;
+        for (uint64_t b = 0; b < blocks; b++) {
+            uint64_t c = start[b * DEDUP_PARTITIONS + p];
+            start[b * DEDUP_PARTITIONS + p] = running;
+            running += c;
+        }
+    }
+    partitionStart[DEDUP_PARTITIONS] = running;
+    vector<uint32_t> order(n);
+    parallelFor(blocks, threads, [&](uint64_t b) {
+        size_t end = min(n, (size_t)(b + 1) * WORKLOAD_CHUNK);
+        for (size_t i = b * WORKLOAD_CHUNK; i < end; i++)
+            order[start[b * DEDUP_PARTITIONS + (hashes[i] >> 56)]++] =
+                (uint32_t)i;
+    });
+
+    parallelFor(DEDUP_PARTITIONS, threads, [&](uint64_t p) {
+        uint64_t first = partitionStart[p], last = partitionStart[p + 1];
+        size_t capacity = 16;
+        while (capacity < 2 * (last - first))
+            capacity *= 2;
+        vector<uint64_t> seen(capacity, 0); // 0 = empty
+        bool seenZero = false;
+        for (uint64_t j = first; j < last; j++) {
+            uint32_t i = order[j];
+            uint64_t h = hashes[i];
+            if (h == 0) {
+                if (seenZero)
+                    keep[i] = 0;
+                seenZero = true;
+                continue;
+            }
+            size_t slot = h & (capacity - 1);
+            while (seen[slot] != 0 && seen[slot] != h)
+                slot = (slot + 1) & (capacity - 1);
+            if (seen[slot] == h)
+                keep[i] = 0;
+            seen[slot] = h;
+        }
+    });
+}
+
+inline void checkSpec(const WorkloadSpec &spec) {
+    if (spec.minLength < 1 || spec.maxLength > MAX_KEY_LENGTH ||
+        (spec.lengths != FIXED_LENGTH && spec.maxLength < spec.minLength))
+        throw invalid_argument("Workload: bad key lengths");
+    if (spec.distribution == ADVERSARIAL_KEYS &&
+        (!spec.bucketHash || spec.buckets == 0 ||
+         spec.targetBucket >= spec.buckets))
+        throw invalid_argument("Workload: adversarial keys need a bucketHash, "
+                               "buckets > 0 and targetBucket < buckets");
+    if (spec.distribution == ZIPF_KEYS && spec.zipfExponent <= 0)
+        throw invalid_argument("Workload: Zipf exponent must be > 0");
+}
+
+// count unique keys drawn according to spec (ZIPF_KEYS: uniform random keys,
+// the universe of the Zipf draws). Duplicates are dropped and replaced by
+// keys of the following chunks until count keys are left.
+inline KeyArena generateKeys(const WorkloadSpec &spec, uint64_t count) {
+    checkSpec(spec);
+    if (count > UINT32_MAX)
+        throw invalid_argument("Workload: at most 2^32 - 1 unique keys");
+    int threads = workloadThreads(spec.threads);
+    KeyArena keys;
+    uint64_t nextChunk = 0;
+    for (int round = 0; keys.size() < count; round++) {
+        if (round == MAX_DEDUP_ROUNDS)
+            throw runtime_error("Workload: key space too small for " +
+                                to_string(count) + " unique keys");
+        uint64_t chunks = (count - keys.size() + WORKLOAD_CHUNK - 1) /
+                          WORKLOAD_CHUNK;
+        vector<KeyArena> parts(chunks);
+        parallelFor(chunks, threads, [&](uint64_t c) {
+            generateChunk(spec, nextChunk + c, parts[c]);
+        });
+        nextChunk += chunks;
+        for (auto &part : parts)
+            keys.append(part);
+        keys.truncate(count);
+
+        // Sequential keys are unique by construction
+        if (spec.distribution != SEQUENTIAL_KEYS) {
+            vector<char> keep(keys.size(), 1);
+            markDuplicates(keys, keep, threads);
+            keys.compact(keep);
+        }
+    }
+    return keys;
+}
+
+inline KeyArena generateKeys(const WorkloadSpec &spec) {
+    return generateKeys(spec, spec.distribution == ZIPF_KEYS && spec.universe
+                                  ? spec.universe
+                                  : spec.count);
+}
+
+// ---------------- BINARY FILE ----------------
+// Header, then one record per key: 16-bit length and the key bytes. Numbers
+// are stored in the byte order of the machine that wrote the file.
+
+const char WORKLOAD_MAGIC[8] = {'H', 'T', 'W', 'O', 'R', 'K', '0', '1'};
+
+struct WorkloadHeader {
+    char magic[8];
+    uint64_t count;    // Records
+    uint64_t universe; // Distinct keys among them
+    uint64_t seed;
+    uint32_t distribution; // KeyDistribution
+    uint32_t unique;       // 1 if no key appears twice
+    uint64_t keyBytes;     // Sum of the key lengths
+};
+
+class WorkloadWriter {
+  private:
+    FILE *file;
+    WorkloadHeader header;
+    vector<char> buffer;
+
+    void flush() {
+        if (!buffer.empty() &&
+            fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+            throw runtime_error("Workload: write failed");
+        buffer.clear();
+    }
+
+  public:
+    WorkloadWriter(const string &path, const WorkloadSpec &spec,
+                   uint64_t universe, bool unique)
+        : file(fopen(path.c_str(), "wb")) {
+        if (file == nullptr)
+            throw runtime_error("Workload: cannot create " + path);
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC));
+        header.universe = universe;
+        header.seed = spec.seed;
+        header.distribution = spec.distribution;
+        header.unique = unique;
+        // Rewritten with the final counts by close()
+        if (fwrite(&header, sizeof(header), 1, file) != 1)
+            throw runtime_error("Workload: write failed");
+    }
+    WorkloadWriter(const WorkloadWriter &) = delete;
+    WorkloadWriter &operator=(const WorkloadWriter &) = delete;
+
+    ~WorkloadWriter() {
+        if (file != nullptr)
+            fclose(file);
+    }
+
+    void add(string_view key) {
+        uint16_t len = (uint16_t)key.size();
+        const char *p = (const char *)&len;
+        buffer.insert(buffer.end(), p, p + sizeof(len));
+        buffer.insert(buffer.end(), key.begin(), key.end());
+        header.count++;
+        header.keyBytes += key.size();
+        if (buffer.size() >= (1 << 20))
+            flush();
+    }
+
+    void add(const KeyArena &keys) {
+        for (size_t i = 0; i < keys.size(); i++)
+            add(keys.view(i));
+    }
+
+    void close() {
+        flush();
+        if (fseek(file, 0, SEEK_SET) != 0 ||
+            fwrite(&header, sizeof(header), 1, file) != 1 || fclose(file) != 0) {
+            file = nullptr;
+            throw runtime_error("Workload: write failed");
+        }
+        file = nullptr;
+    }
+};
+
+// Generates the workload of spec into path. Unique distributions write the
+// keys in generation order; ZIPF_KEYS writes spec.count draws, produced and
+// written a batch of chunks at a time so the stream is never held in memory.
+inline void writeWorkload(const string &path, const WorkloadSpec &spec) {
+    KeyArena keys = generateKeys(spec);
+    if (spec.distribution != ZIPF_KEYS) {
+        WorkloadWriter writer(path, spec, keys.size(), true);
+        writer.add(keys);
+        writer.close();
+        return;
+    }
+
+    int threads = workloadThreads(spec.threads);
+    ZipfSampler zipf(keys.size(), spec.zipfExponent);
+    WorkloadWriter writer(path, spec, keys.size(), false);
+    uint64_t chunks = (spec.count + WORKLOAD_CHUNK - 1) / WORKLOAD_CHUNK;
+    uint64_t batch = 4 * (uint64_t)threads;
+    for (uint64_t first = 0; first < chunks; first += batch) {
+        uint64_t n = min(batch, chunks - first);
+        vector<vector<uint32_t>> ranks(n);
+        parallelFor(n, threads, [&](uint64_t c) {
+            uint64_t chunk = first + c;
+            uint64_t state = chunkSeed(spec.seed, chunk, 1);
+            uint64_t draws = min((uint64_t)WORKLOAD_CHUNK,
+                                 spec.count - chunk * WORKLOAD_CHUNK);
+            ranks[c].resize(draws);
+            for (auto &r : ranks[c])
+                r = (uint32_t)zipf(state);
+        });
+        for (auto &part : ranks)
+            for (uint32_t r : part)
+                writer.add(keys.view(r - 1));
+    }
+    writer.close();
+}
+
+// Streams the keys of a workload file through a fixed-size buffer
+class WorkloadReader {
+  private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    FILE *file;
+    WorkloadHeader header;
+    vector<char> buffer;
+    size_t pos, end;
+    uint64_t consumed;
+
+    // Makes at least n bytes available at pos
+    bool fill(size_t n) {
+        if (end - pos >= n)
+            return true;
+        memmove(buffer.data(), buffer.data() + pos, end - pos);
+        end -= pos;
+        pos = 0;
+        end += fread(buffer.data() + end, 1, buffer.size() - end, file);
+        return end >= n;
+    }
+
+  public:
+    explicit WorkloadReader(const string &path)
+        : file(fopen(path.c_str(), "rb")), buffer(BUFFER_SIZE), pos(0),
+          end(0), consumed(0) {
+        if (file == nullptr)
+            throw runtime_error("Workload: cannot open " + path);
+        if (fread(&header, sizeof(header), 1, file) != 1 ||
+            memcmp(header.magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC)) != 0) {
+            fclose(file);
+            throw runtime_error("Workload: " + path + " is not a workload file");
+        }
+    }
+    WorkloadReader(const WorkloadReader &) = delete;
+    WorkloadReader &operator=(const WorkloadReader &) = delete;
+
+    ~WorkloadReader() { fclose(file); }
+
+    const WorkloadHeader &getHeader() const { return header; }
+
+    // Next key, or false at the end of the workload
+    bool next(string &key) {
+        if (consumed == header.count)
+            return false;
+        uint16_t len;
+        if (!fill(sizeof(len)))
+            throw runtime_error("Workload: file is truncated");
+        memcpy(&len, buffer.data() + pos, sizeof(len));
+        if (!fill(sizeof(len) + len))
+            throw runtime_error("Workload: file is truncated");
+        key.assign(buffer.data() + pos + sizeof(len), len);
+        pos += sizeof(len) + len;
+        consumed++;
+        return true;
+    }
+
+    // Up to max next keys into keys (resized); returns how many
+    size_t nextBatch(vector<string> &keys, size_t max) {
+        keys.resize(max);
+        size_t n = 0;
+        while (n < max && next(keys[n]))
+            n++;
+        keys.resize(n);
+        return n;
+    }
+
+    void rewind() {
+        if (fseek(file, sizeof(header), SEEK_SET) != 0)
+            throw runtime_error("Workload: seek failed");
+        pos = end = 0;
+        consumed = 0;
+    }
+};
+
+inline vector<string> readWorkload(const string &path) {
+    WorkloadReader reader(path);
+    vector<string> keys;
+    keys.reserve(reader.getHeader().count);
+    string key;
+    while (reader.next(key))
+        keys.push_back(key);
+    return keys;
+}
+
+#endif // WORKLOAD_H
@@ -0,0 +1,102 @@
+#include "HashTable.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Scalar insert/search loops against insertBatch/searchBatch on random
+// 10-letter words. Keys are searched in random order, so once the table is
+// larger than the last-level cache nearly every lookup misses in cache.
+// Usage: ./batch_benchmark [numWords...]   (default: 10000 1000000 4000000)
+
+const int WORD_LENGTH = 10;
+
+vector<string> randomWords(int count, mt19937 &gen) {
+    uniform_int_distribution<> dis(0, 25);
+    vector<string> words(count, string(WORD_LENGTH, 'a'));
+    for (auto &w : words)
+        for (auto &c : w)
+            c = char('a' + dis(gen));
+    return words;
+}
+
+double nsPerOp(chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double, nano>(elapsed).count() / ops;
+}
+
+void benchmark(const char *name, CollisionMethod method,
+               const vector<string> &words, const vector<string> &lookups) {
+    int n = words.size();
+    vector<int> values(n);
+    for (int i = 0; i < n; i++)
+        values[i] = i;
+
+    HashTable<string, int> scalar(method, 1);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        scalar.insert(words[i], values[i]);
+    double insertNs = nsPerOp(start, n);
+
+    HashTable<string, int> batched(method, 1);
+    start = chrono::steady_clock::now();
+    batched.insertBatch(words.data(), values.data(), n);
+    double insertBatchNs = nsPerOp(start, n);
+
+    int value;
+    long long found = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        found += scalar.search(lookups[i], value);
+    double searchNs = nsPerOp(start, n);
+
+    unique_ptr<int[]> results(new int[n]);
+    start = chrono::steady_clock::now();
+    long long foundBatch = batched.searchBatch(lookups.data(), n, results.get());
+    double searchBatchNs = nsPerOp(start, n);
+
+    cout << left << setw(10) << name << right << fixed << setprecision(1)
+         << setw(11) << insertNs << setw(11) << insertBatchNs
+         << setprecision(2) << setw(9) << insertNs / insertBatchNs
+         << setprecision(1) << setw(11) << searchNs << setw(11)
+         << searchBatchNs << setprecision(2) << setw(9)
+         << searchNs / searchBatchNs << "   (" << found << "/" << foundBatch
+         << " found)" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(atoi(argv[i]));
+    if (sizes.empty())
+        sizes = {10000, 1000000, 4000000};
+
+    mt19937 gen(42);
+    for (int n : sizes) {
+        vector<string> words = randomWords(n, gen);
+        // Half hits, half misses (upper case), in random order
+        vector<string> lookups(words);
+        for (int i = 0; i < n; i += 2)
+            lookups[i][0] = 'A';
+        shuffle(lookups.begin(), lookups.end(), gen);
+
+        cout << "=== " << n << " words ===" << endl;
+        cout << left << setw(10) << "Method" << right << setw(11)
+             << "insert ns" << setw(11) << "batch ns" << setw(9) << "speedup"
+             << setw(11) << "search ns" << setw(11) << "batch ns" << setw(9)
+             << "speedup" << endl;
+        benchmark("Chaining", CHAINING, words, lookups);
+        benchmark("Double", DOUBLE_HASHING, words, lookups);
+        benchmark("Group", GROUP_PROBING, words, lookups);
+        benchmark("Robin", ROBIN_HOOD, words, lookups);
+        benchmark("Cuckoo", CUCKOO_HASHING, words, lookups);
+        cout << endl;
+    }
+    return 0;
+}
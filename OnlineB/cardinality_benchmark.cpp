@@ -0,0 +1,115 @@
+#include "HyperLogLog.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+// Distinct counting of an event stream: unordered_set (as count-distinct.cpp
+// does it), DistinctCounter in both modes (countDistinctExact and
+// countDistinctApprox there), and HyperLogLog sketches, serially and merged
+// from per-thread sketches. Memory of the
+// unordered_set is estimated as its bucket array plus one node per key.
+// Usage: ./cardinality_benchmark [events] [distinct] [threads]
+//        (default: 20000000 5000000, one thread per hardware thread)
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double>(elapsed).count();
+}
+
+void printRow(const string &name, double seconds, size_t events,
+              size_t bytes, uint64_t count, uint64_t distinct) {
+    double error = 100.0 * ((double)count - distinct) / distinct;
+    cout << left << setw(18) << name << right << fixed << setprecision(3)
+         << setw(9) << seconds << setprecision(1) << setw(11)
+         << events / seconds / 1e6 << setprecision(3) << setw(13)
+         << bytes / 1048576.0 << setw(12) << count << setprecision(2)
+         << setw(9) << error << endl;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = (argc > 1) ? atoll(argv[1]) : 20000000;
+    uint64_t distinct = (argc > 2) ? atoll(argv[2]) : 5000000;
+    int threads = workloadThreads((argc > 3) ? atoi(argv[3]) : 0);
+
+    // Every one of the distinct ids once, then random repeats, shuffled
+    uint64_t state = 42;
+    vector<uint64_t> ids(distinct);
+    for (auto &id : ids)
+        id = splitMix64(state);
+    vector<uint64_t> events(n);
+    for (size_t i = 0; i < n; i++)
+        events[i] = ids[i < distinct ? i : splitMix64(state) % distinct];
+    for (size_t i = n - 1; i > 0; i--)
+        swap(events[i], events[splitMix64(state) % (i + 1)]);
+    distinct = min<uint64_t>(distinct, n);
+
+    cout << n << " events, " << distinct << " distinct, " << threads
+         << " threads" << endl;
+    cout << left << setw(18) << "Counter" << right << setw(9) << "seconds"
+         << setw(11) << "Mevents/s" << setw(13) << "memory MiB" << setw(12)
+         << "count" << setw(9) << "error %" << endl;
+
+    {
+        auto start = chrono::steady_clock::now();
+        unordered_set<uint64_t> s;
+        for (uint64_t e : events)
+            s.insert(e);
+        double seconds = secondsSince(start);
+        size_t bytes = s.bucket_count() * sizeof(void *) +
+                       s.size() * (sizeof(void *) + sizeof(uint64_t));
+        printRow("unordered_set", seconds, n, bytes, s.size(), distinct);
+    }
+    {
+        auto start = chrono::steady_clock::now();
+        DistinctCounter<uint64_t> exact(DISTINCT_EXACT);
+        for (uint64_t e : events)
+            exact.add(e);
+        printRow("exact HashTable", secondsSince(start), n,
+                 exact.memoryBytes(), exact.count(), distinct);
+    }
+    {
+        auto start = chrono::steady_clock::now();
+        DistinctCounter<uint64_t> approximate(DISTINCT_APPROXIMATE);
+        for (uint64_t e : events)
+            approximate.add(e);
+        uint64_t count = approximate.count();
+        printRow("approx counter", secondsSince(start), n,
+                 approximate.memoryBytes(), count, distinct);
+    }
+    for (int p : {10, 14, 18}) {
+        auto start = chrono::steady_clock::now();
+        HyperLogLog sketch(p);
+        for (uint64_t e : events)
+            sketch.add(e);
+        uint64_t count = sketch.count();
+        printRow("hll p=" + to_string(p), secondsSince(start), n,
+                 sketch.memoryBytes(), count, distinct);
+    }
+    {
+        auto start = chrono::steady_clock::now();
+        HyperLogLog sketch = countDistinctParallel(events.data(), n, threads);
+        uint64_t count = sketch.count();
+        printRow("hll p=14 parallel", secondsSince(start), n,
+                 threads * sketch.memoryBytes(), count, distinct);
+    }
+
+    // Merging per-shard sketches: one SIMD max over the registers each
+    const int SHARDS = 256;
+    vector<HyperLogLog> shards(SHARDS);
+    for (size_t i = 0; i < n; i++)
+        shards[events[i] % SHARDS].add(events[i]);
+    auto start = chrono::steady_clock::now();
+    HyperLogLog total;
+    for (const HyperLogLog &s : shards)
+        total.merge(s);
+    double seconds = secondsSince(start);
+    cout << "merged " << SHARDS << " shard sketches in " << fixed
+         << setprecision(1) << seconds * 1e6 << " us, count "
+         << total.count() << endl;
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "LockFreeHashTable.h"
+#include "ShardedHashTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Throughput of ShardedHashTable and LockFreeHashTable with R reader and W
+// writer threads, against a single-shard table (one global reader-writer
+// lock).
+// Readers search random keys (about half of them present); writers insert
+// and remove keys of a separate range, so the table size stays steady.
+// Usage: ./concurrency_benchmark [numKeys] [msPerRun]
+//        (default: 1000000 300; build with -pthread)
+
+const int READER_COUNTS[] = {1, 2, 4, 8, 16, 32};
+const int WRITER_COUNTS[] = {0, 1, 4};
+
+enum TableKind { SINGLE_LOCK, SHARDED, LOCK_FREE };
+const char *TABLE_NAMES[] = {"1 lock", "sharded", "lock-free"};
+
+// splitmix64: cheap per-thread random keys
+uint64_t nextRandom(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+struct RunResult {
+    double readsPerSec;
+    double writesPerSec;
+};
+
+template <typename Table>
+RunResult run(Table &table, long long numKeys, int readers, int writers,
+              int ms) {
+    for (long long k = 0; k < numKeys; k++)
+        table.insert(k, k);
+
+    atomic<bool> start(false), stop(false);
+    vector<long long> ops(readers + writers, 0);
+    vector<thread> threads;
+
+    for (int t = 0; t < readers + writers; t++) {
+        threads.emplace_back([&, t] {
+            uint64_t rng = 12345 + t;
+            bool writer = t >= readers;
+            long long done = 0, value;
+            while (!start.load(memory_order_acquire))
+                this_thread::yield();
+            while (!stop.load(memory_order_relaxed)) {
+                // Check the clock flag only every 64 operations
+                for (int i = 0; i < 64; i++) {
+                    long long k = nextRandom(rng) % (2 * numKeys);
+                    if (!writer) {
+                        table.search(k, value);
+                    } else {
+                        k += 2 * numKeys; // Never a key the readers look for
+                        if (!table.insert(k, k))
+                            table.remove(k);
+                    }
+                }
+                done += 64;
+            }
+            ops[t] = done;
+        });
+    }
+
+    auto begin = chrono::steady_clock::now();
+    start.store(true, memory_order_release);
+    this_thread::sleep_for(chrono::milliseconds(ms));
+    stop.store(true);
+    for (auto &th : threads)
+        th.join();
+    double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    RunResult r = {0, 0};
+    for (int t = 0; t < readers + writers; t++)
+        (t < readers ? r.readsPerSec : r.writesPerSec) += ops[t] / seconds;
+    return r;
+}
+
+int main(int argc, char *argv[]) {
+    long long numKeys = (argc > 1) ? atoll(argv[1]) : 1000000;
+    int ms = (argc > 2) ? atoi(argv[2]) : 300;
+    int hardwareThreads = max(1u, thread::hardware_concurrency());
+
+    cout << numKeys << " keys, " << ms << " ms per run, " << hardwareThreads
+         << " hardware threads" << endl;
+    cout << left << setw(10) << "Table" << right << setw(9) << "readers"
+         << setw(9) << "writers" << setw(14) << "reads M/s" << setw(14)
+         << "writes M/s" << setw(16) << "M ops/s/core" << endl;
+
+    for (int writers : WRITER_COUNTS) {
+        for (int readers : READER_COUNTS) {
+            int cores = min(readers + writers, hardwareThreads);
+            for (TableKind kind : {SINGLE_LOCK, SHARDED, LOCK_FREE}) {
+                RunResult r;
+                if (kind == LOCK_FREE) {
+                    LockFreeHashTable<long long, long long> table;
+                    r = run(table, numKeys, readers, writers, ms);
+                } else {
+                    ShardedHashTable<long long, long long> table(
+                        DOUBLE_HASHING, 1,
+                        kind == SINGLE_LOCK ? 1 : DEFAULT_SHARD_COUNT);
+                    r = run(table, numKeys, readers, writers, ms);
+                }
+                double total = r.readsPerSec + r.writesPerSec;
+                cout << left << setw(10) << TABLE_NAMES[kind] << right
+                     << setw(9)
+                     << readers << setw(9) << writers << fixed
+                     << setprecision(2) << setw(14) << r.readsPerSec / 1e6
+                     << setw(14) << r.writesPerSec / 1e6 << setw(16)
+                     << total / cores / 1e6 << endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "DiskHashTable.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// DiskHashTable with buffer pools of different sizes against the in-memory
+// HashTable, on random 64-bit keys. Reads and writes are page transfers
+// between the pool and the file (the OS page cache may still serve them).
+// Usage: ./disk_benchmark [numKeys] [file] [poolPages...]
+//        (default: 2000000 /tmp/hashtable.disk 256 4096 65536)
+
+double nsPerOp(chrono::steady_clock::time_point start, long long ops) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double, nano>(elapsed).count() / ops;
+}
+
+void printRow(const string &name, double insertNs, double hitNs,
+              double missNs, double readsPerLookup, long long writes) {
+    cout << left << setw(16) << name << right << fixed << setprecision(1)
+         << setw(11) << insertNs << setw(9) << hitNs << setw(9) << missNs
+         << setprecision(3) << setw(13) << readsPerLookup << setw(12)
+         << writes << endl;
+}
+
+void benchmarkDisk(const string &path, int poolPages,
+                   const vector<long long> &keys,
+                   const vector<long long> &missing) {
+    DiskHashTable<long long, long long> table(path, DISK_CREATE, poolPages);
+    long long n = keys.size();
+
+    auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < n; i++)
+        table.insert(keys[i], i);
+    double insertNs = nsPerOp(start, n);
+    long long writes = table.getPageWrites();
+
+    long long value, found = 0;
+    table.resetStatistics();
+    start = chrono::steady_clock::now();
+    for (long long i = 0; i < n; i++)
+        found += table.search(keys[i], value);
+    double hitNs = nsPerOp(start, n);
+    start = chrono::steady_clock::now();
+    for (long long i = 0; i < n; i++)
+        found += table.search(missing[i], value);
+    double missNs = nsPerOp(start, n);
+    double reads = (double)table.getPageReads() / (2 * n);
+
+    printRow("disk/" + to_string(poolPages), insertNs, hitNs, missNs, reads,
+             writes);
+    cout << "    " << table.getPageCount() << " pages, directory depth "
+         << table.getGlobalDepth() << ", " << found << " found" << endl;
+}
+
+void benchmarkMemory(const vector<long long> &keys,
+                     const vector<long long> &missing) {
+    HashTable<long long, long long> table(DOUBLE_HASHING, 1);
+    long long n = keys.size();
+
+    auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < n; i++)
+        table.insert(keys[i], i);
+    double insertNs = nsPerOp(start, n);
+
+    long long value, found = 0;
+    start = chrono::steady_clock::now();
+    for (long long i = 0; i < n; i++)
+        found += table.search(keys[i], value);
+    double hitNs = nsPerOp(start, n);
+    start = chrono::steady_clock::now();
+    for (long long i = 0; i < n; i++)
+        found += table.search(missing[i], value);
+    double missNs = nsPerOp(start, n);
+
+    printRow("memory", insertNs, hitNs, missNs, 0, 0);
+}
+
+int main(int argc, char *argv[]) {
+    long long n = (argc > 1) ? atoll(argv[1]) : 2000000;
+    string path = (argc > 2) ? argv[2] : "/tmp/hashtable.disk";
+    vector<int> pools;
+    for (int i = 3; i < argc; i++)
+        pools.push_back(atoi(argv[i]));
+    if (pools.empty())
+        pools = {256, 4096, 65536};
+
+    // Even keys are inserted, odd ones are the misses
+    mt19937_64 gen(42);
+    vector<long long> keys(n), missing(n);
+    for (long long i = 0; i < n; i++) {
+        keys[i] = (long long)(gen() & ~1ULL);
+        missing[i] = keys[i] | 1;
+    }
+
+    cout << n << " keys, " << DISK_PAGE_SIZE << "-byte pages" << endl;
+    cout << left << setw(16) << "Table" << right << setw(11) << "insert ns"
+         << setw(9) << "hit ns" << setw(9) << "miss ns" << setw(13)
+         << "reads/lookup" << setw(12) << "page writes" << endl;
+    for (int pages : pools)
+        benchmarkDisk(path, pages, keys, missing);
+    benchmarkMemory(keys, missing);
+    unlink(path.c_str());
+    return 0;
+}
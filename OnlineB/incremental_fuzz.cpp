@@ -0,0 +1,136 @@
+#include "HashTable.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Differential fuzz of HashTable with incremental resizing against
+// unordered_map: random inserts and removes over a small key space, so that
+// many operations land while a migration is in progress, and searches for
+// keys the model holds. Every result and every found value must match the
+// model. Regression check for Robin Hood migration, which once left old
+// generation tombstones with the hash of another key, and for the probe
+// counts of searches during a migration.
+// Usage: ./incremental_fuzz [ops] [seeds]   (default: 2000 2000)
+//        (exits with 1 on the first mismatch)
+
+const char *methodNames[] = {"chaining", "double", "custom",
+                             "group",    "robin",  "cuckoo"};
+
+uint64_t nextRandom(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int intKey(uint64_t id) { return (int)id; }
+
+string stringKey(uint64_t id) { return to_string(id); }
+
+template <typename K>
+bool fuzz(CollisionMethod method, K (*makeKey)(uint64_t), int ops,
+          uint64_t seed) {
+    HashTable<K, int> table(method, 1, true);
+    unordered_map<K, int> model;
+    vector<K> present; // The model's keys, to search them at random
+    uint64_t state = seed;
+    // Runs are short and many: most of them start from an empty table, and
+    // the small tables of the first resizes are where probe sequences
+    // through a half migrated generation go wrong
+    uint64_t keySpace = 16 << (seed % 8);
+    for (int i = 0; i < ops; i++) {
+        int op = nextRandom(state) % 10;
+        K key = makeKey(nextRandom(state) % keySpace);
+        if (op >= 7 && !present.empty())
+            key = present[nextRandom(state) % present.size()];
+        int value = (int)(nextRandom(state) & 0xFFFF);
+        bool got, expected;
+        if (op < 4) {
+            got = table.insert(key, value);
+            expected = model.emplace(key, value).second;
+            if (expected)
+                present.push_back(key);
+        } else if (op < 7) {
+            got = table.remove(key);
+            expected = model.erase(key) > 0;
+            if (expected) {
+                *find(present.begin(), present.end(), key) = present.back();
+                present.pop_back();
+            }
+        } else {
+            int found = 0;
+            got = table.search(key, found);
+            auto it = model.find(key);
+            expected = it != model.end();
+            if (got && expected && found != it->second) {
+                cerr << "FAILED: " << methodNames[method] << " seed " << seed
+                     << " op " << i << ": wrong value" << endl;
+                return false;
+            }
+        }
+        if (got != expected) {
+            cerr << "FAILED: " << methodNames[method] << " seed " << seed
+                 << " op " << i << ": " << (op < 4   ? "insert"
+                                            : op < 7 ? "remove"
+                                                     : "search")
+                 << " returned " << got << endl;
+            return false;
+        }
+    }
+    // Everything the model holds must still be found
+    for (const auto &entry : model) {
+        int found;
+        if (!table.search(entry.first, found) || found != entry.second) {
+            cerr << "FAILED: " << methodNames[method] << " seed " << seed
+                 << ": key lost" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Searches that miss while the table keeps growing must take about as many
+// probes with incremental resizing as without: a migrated part of the old
+// generation that no longer ends probe sequences makes them O(n)
+bool checkProbes(CollisionMethod method) {
+    const int n = 200000;
+    double probes[2];
+    for (int incremental = 0; incremental < 2; incremental++) {
+        HashTable<int, int> table(method, 1, incremental);
+        for (int i = 0; i < n; i++) {
+            int found;
+            table.insert(2 * i, i);
+            table.search(2 * i + 1, found);
+        }
+        probes[incremental] = table.getAverageProbes();
+    }
+    if (probes[1] > 2 * probes[0] + 1) {
+        cerr << "FAILED: " << methodNames[method] << ": " << probes[1]
+             << " probes per search while migrating, " << probes[0]
+             << " without" << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int ops = (argc > 1) ? atoi(argv[1]) : 2000;
+    int seeds = (argc > 2) ? atoi(argv[2]) : 2000;
+
+    for (int m = CHAINING; m <= CUCKOO_HASHING; m++) {
+        CollisionMethod method = (CollisionMethod)m;
+        for (int s = 1; s <= seeds; s++)
+            if (!fuzz<int>(method, intKey, ops, s) ||
+                !fuzz<string>(method, stringKey, ops, s))
+                return 1;
+        if (!checkProbes(method))
+            return 1;
+        cout << methodNames[m] << ": ok" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "HashTable.h"
+#include "InputReader.h"
+#include "Workload.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Parsing whitespace-separated integers and words from a text file with
+// iostream extraction against InputReader (mapped, and in block reads), and
+// bulk-inserting the words without a string per token.
+// Usage: ./input_benchmark [numTokens] [directory]   (default: 10000000 /tmp)
+
+const size_t BATCH = 1 << 16;
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double>(elapsed).count();
+}
+
+void printRow(const char *name, double seconds, long long tokens,
+              long long checksum) {
+    cout << left << setw(24) << name << right << fixed << setprecision(3)
+         << setw(10) << seconds << setprecision(1) << setw(12)
+         << seconds * 1e9 / tokens << "   (" << checksum << ")" << endl;
+}
+
+void benchmarkInts(const string &path, long long n) {
+    auto start = chrono::steady_clock::now();
+    ifstream file(path);
+    long long value, sum = 0;
+    while (file >> value)
+        sum += value;
+    printRow("ints: ifstream >>", secondsSince(start), n, sum);
+
+    for (bool map : {true, false}) {
+        start = chrono::steady_clock::now();
+        InputReader in(path, map);
+        vector<int64_t> batch;
+        sum = 0;
+        while (in.nextInts(batch, BATCH) > 0)
+            for (int64_t v : batch)
+                sum += v;
+        printRow(map ? "ints: InputReader mmap" : "ints: InputReader read",
+                 secondsSince(start), n, sum);
+    }
+}
+
+void benchmarkWords(const string &path, long long n) {
+    auto start = chrono::steady_clock::now();
+    {
+        ifstream file(path);
+        HashTable<string, int, WyHash> table(GROUP_PROBING, 1);
+        string word;
+        while (file >> word)
+            table.insert(word, 1);
+        printRow("words: ifstream + insert", secondsSince(start), n,
+                 table.getSize());
+    }
+
+    // The views point into the mapping, which outlives the table
+    start = chrono::steady_clock::now();
+    InputReader in(path);
+    HashTable<string_view, int, WyHash> table(GROUP_PROBING, 1);
+    vector<string_view> batch;
+    vector<int> ones(BATCH, 1);
+    while (in.nextWords(batch, BATCH) > 0)
+        table.insertBatch(batch.data(), ones.data(), batch.size());
+    printRow("words: mmap + batch", secondsSince(start), n, table.getSize());
+}
+
+int main(int argc, char *argv[]) {
+    long long n = (argc > 1) ? atoll(argv[1]) : 10000000;
+    string dir = (argc > 2) ? argv[2] : "/tmp";
+    string intPath = dir + "/input_ints.txt";
+    string wordPath = dir + "/input_words.txt";
+
+    {
+        ofstream ints(intPath), words(wordPath);
+        uint64_t state = 42;
+        for (long long i = 0; i < n; i++)
+            ints << (int64_t)(splitMix64(state) >> 20) - (1LL << 43) << '\n';
+        WorkloadSpec spec;
+        spec.count = n;
+        spec.lengths = UNIFORM_LENGTH;
+        spec.minLength = 4;
+        spec.maxLength = 12;
+        KeyArena keys = generateKeys(spec);
+        for (size_t i = 0; i < keys.size(); i++)
+            words << keys.view(i) << ((i % 8 == 7) ? '\n' : ' ');
+    }
+
+    cout << n << " tokens" << endl;
+    cout << left << setw(24) << "Reader" << right << setw(10) << "seconds"
+         << setw(12) << "ns/token" << endl;
+    benchmarkInts(intPath, n);
+    benchmarkWords(wordPath, n);
+    remove(intPath.c_str());
+    remove(wordPath.c_str());
+    return 0;
+}
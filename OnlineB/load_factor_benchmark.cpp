@@ -0,0 +1,117 @@
+#include "HashTable.h"
+#include "Workload.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// The open addressing methods at high load factors: Robin Hood and cuckoo
+// hashing against double hashing and group probing. Each table is filled to just below the target load (at a
+// capacity of at least minCapacity) and then measured: lookups of present
+// and missing keys, and a churn phase of remove + insert pairs, which leaves
+// tombstones everywhere except in the Robin Hood and cuckoo tables.
+// Usage: ./load_factor_benchmark [minCapacity] [loads...]
+//        (default: 1000000 0.5 0.7 0.8 0.9 0.95)
+//        (build with -DHASHTABLE_STATS to also print probe histograms)
+
+double nsPerOp(chrono::steady_clock::time_point start, long long ops) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double, nano>(elapsed).count() / ops;
+}
+
+void benchmark(const char *name, CollisionMethod method, double load,
+               int minCapacity, const vector<string> &keys,
+               const vector<string> &missing) {
+    HashTable<string, int, WyHash> table(method, 1);
+    table.setMaxLoadFactor(load);
+
+    // Stop at the last key that still fits under the threshold
+    int n = 0;
+    auto start = chrono::steady_clock::now();
+    while (n < (int)keys.size() &&
+           (table.getCapacity() < minCapacity ||
+            table.getSize() + 1 <= load * table.getCapacity()))
+        table.insert(keys[n], n), n++;
+    double insertNs = nsPerOp(start, n);
+    if (n == (int)keys.size()) {
+        cout << left << setw(12) << name << "   (not enough keys)" << endl;
+        return;
+    }
+
+    int value;
+    long long found = 0;
+    table.resetStatistics();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        found += table.search(keys[i], value);
+    double hitNs = nsPerOp(start, n);
+    double hitProbes = table.getAverageProbes();
+
+    table.resetStatistics();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        found += table.search(missing[i], value);
+    double missNs = nsPerOp(start, n);
+    double missProbes = table.getAverageProbes();
+
+    // Remove the oldest key, insert a new one: the load stays put
+    int churn = min(n, (int)keys.size() - n);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < churn; i++) {
+        table.remove(keys[i]);
+        table.insert(keys[n + i], n + i);
+    }
+    double churnNs = nsPerOp(start, 2LL * churn);
+
+    cout << left << setw(12) << name << right << fixed << setprecision(3)
+         << setw(7) << table.getLoadFactor() << setprecision(1) << setw(11)
+         << insertNs << setw(9) << hitNs << setw(9) << missNs << setw(10)
+         << churnNs << setprecision(2) << setw(9) << hitProbes << setw(9)
+         << missProbes << setw(8) << table.getTombstoneCount()
+         << "   (" << found << " found)" << endl;
+#ifdef HASHTABLE_STATS
+    table.getStatsSnapshot().print(cout);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    int minCapacity = (argc > 1) ? atoi(argv[1]) : 1000000;
+    vector<double> loads;
+    for (int i = 2; i < argc; i++)
+        loads.push_back(atof(argv[i]));
+    if (loads.empty())
+        loads = {0.5, 0.7, 0.8, 0.9, 0.95};
+
+    // Tables grow to at most about 2 * minCapacity; the keys after the
+    // ones inserted are the churn phase's new keys
+    WorkloadSpec spec;
+    spec.count = 4LL * minCapacity;
+    spec.minLength = spec.maxLength = 10;
+    vector<string> keys = generateKeys(spec).toStrings();
+    spec.seed++;
+    // Upper-case keys can never collide with the inserted ones
+    vector<string> missing = generateKeys(spec).toStrings();
+    for (auto &k : missing)
+        k[0] = 'A';
+
+    for (double load : loads) {
+        cout << "=== max load " << load << " ===" << endl;
+        cout << left << setw(12) << "Method" << right << setw(7) << "load"
+             << setw(11) << "insert ns" << setw(9) << "hit ns" << setw(9)
+             << "miss ns" << setw(10) << "churn ns" << setw(9) << "hit pr"
+             << setw(9) << "miss pr" << setw(8) << "tombs" << endl;
+        benchmark("Double", DOUBLE_HASHING, load, minCapacity, keys, missing);
+        // No coverage guarantee beyond half full
+        if (load <= LOAD_FACTOR_THRESHOLD)
+            benchmark("Custom", CUSTOM_PROBING, load, minCapacity, keys,
+                      missing);
+        benchmark("Group", GROUP_PROBING, load, minCapacity, keys, missing);
+        benchmark("Robin Hood", ROBIN_HOOD, load, minCapacity, keys, missing);
+        benchmark("Cuckoo", CUCKOO_HASHING, load, minCapacity, keys, missing);
+        cout << endl;
+    }
+    return 0;
+}
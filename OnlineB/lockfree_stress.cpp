@@ -0,0 +1,164 @@
+#include "LockFreeHashTable.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Stress test of LockFreeHashTable under concurrent insert/search/remove.
+// Usage: ./lockfree_stress [threads] [opsPerThread]   (default: 8 200000)
+//        (build with -pthread; exits with 1 on the first violation)
+//
+// Phase 1: each thread owns the keys k with k % threads == t and checks every
+//          result against its own exact model, while the others' operations
+//          keep the table resizing under it.
+// Phase 2: all threads insert the same keys; each key must be inserted
+//          exactly once. Then all threads remove them, again exactly once.
+// Phase 3: readers search keys whose value is a known function of the key
+//          while writers insert and remove other keys; a reader must never
+//          see a wrong value.
+
+atomic<bool> failed(false);
+
+void fail(const char *what, long long key) {
+    if (!failed.exchange(true))
+        cerr << "FAILED: " << what << " (key " << key << ")" << endl;
+}
+
+uint64_t nextRandom(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+long long valueOf(long long key) { return key * 7 + 1; }
+
+template <typename F> void runThreads(int count, F body) {
+    vector<thread> threads;
+    for (int t = 0; t < count; t++)
+        threads.emplace_back(body, t);
+    for (auto &th : threads)
+        th.join();
+}
+
+void ownedKeys(int threads, int ops) {
+    LockFreeHashTable<long long, long long> table;
+    const int KEYS_PER_THREAD = 4096;
+    vector<long long> liveCount(threads, 0);
+
+    runThreads(threads, [&](int t) {
+        vector<char> present(KEYS_PER_THREAD, 0);
+        uint64_t rng = 1000 + t;
+        for (int i = 0; i < ops && !failed; i++) {
+            int id = nextRandom(rng) % KEYS_PER_THREAD;
+            long long key = (long long)id * threads + t;
+            long long value;
+            switch (nextRandom(rng) % 3) {
+            case 0:
+                if (table.insert(key, valueOf(key)) != !present[id])
+                    fail("insert result", key);
+                present[id] = 1;
+                break;
+            case 1:
+                if (table.remove(key) != (bool)present[id])
+                    fail("remove result", key);
+                present[id] = 0;
+                break;
+            default:
+                if (table.search(key, value) != (bool)present[id])
+                    fail("search result", key);
+                else if (present[id] && value != valueOf(key))
+                    fail("search value", key);
+            }
+        }
+        for (char p : present)
+            liveCount[t] += p;
+    });
+
+    long long expected = 0;
+    for (long long c : liveCount)
+        expected += c;
+    if (table.getSize() != expected)
+        fail("size after phase 1", table.getSize());
+    cout << "owned keys:   ok, " << table.getResizeCount() << " resizes, "
+         << table.getSize() << " keys left" << endl;
+}
+
+void contendedKeys(int threads, int keys) {
+    LockFreeHashTable<long long, long long> table;
+    atomic<long long> inserted(0), removed(0);
+
+    // Every thread walks the keys from a different starting point
+    runThreads(threads, [&](int t) {
+        long long mine = 0;
+        for (int i = 0; i < keys; i++) {
+            long long key = (i + (long long)t * keys / threads) % keys;
+            mine += table.insert(key, valueOf(key));
+        }
+        inserted += mine;
+    });
+    if (inserted != keys || table.getSize() != keys)
+        fail("concurrent inserts of the same keys", inserted);
+
+    runThreads(threads, [&](int t) {
+        long long mine = 0, value;
+        for (int i = 0; i < keys; i++) {
+            long long key = (i + (long long)t * keys / threads) % keys;
+            if (table.search(key, value) && value != valueOf(key))
+                fail("search value", key);
+            mine += table.remove(key);
+        }
+        removed += mine;
+    });
+    if (removed != keys || table.getSize() != 0)
+        fail("concurrent removes of the same keys", removed);
+    cout << "same keys:    ok, " << keys << " inserted and removed once each"
+         << endl;
+}
+
+void readersAndWriters(int threads, int ops) {
+    LockFreeHashTable<long long, long long> table;
+    const long long STABLE_KEYS = 100000;
+    for (long long k = 0; k < STABLE_KEYS; k++)
+        table.insert(k, valueOf(k));
+
+    int writers = max(1, threads / 2);
+    atomic<long long> lookups(0);
+    runThreads(threads, [&](int t) {
+        uint64_t rng = 2000 + t;
+        if (t < writers) {
+            // Churn on keys the readers never look up, forcing resizes
+            for (int i = 0; i < ops && !failed; i++) {
+                long long key = STABLE_KEYS + nextRandom(rng) % 50000;
+                if (!table.insert(key, valueOf(key)))
+                    table.remove(key);
+            }
+        } else {
+            long long mine = 0, value;
+            for (int i = 0; i < ops && !failed; i++) {
+                long long key = nextRandom(rng) % STABLE_KEYS;
+                if (!table.search(key, value) || value != valueOf(key))
+                    fail("stable key lost or wrong", key);
+                mine++;
+            }
+            lookups += mine;
+        }
+    });
+    cout << "read/write:   ok, " << lookups << " lookups during "
+         << table.getResizeCount() << " resizes" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int ops = (argc > 2) ? atoi(argv[2]) : 200000;
+
+    ownedKeys(threads, ops);
+    if (!failed)
+        contendedKeys(threads, ops);
+    if (!failed)
+        readersAndWriters(threads, ops);
+    return failed ? 1 : 0;
+}
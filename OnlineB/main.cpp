@@ -1,4 +1,6 @@
 #include "HashTable.h"
+#include "InputReader.h"
+#include "Workload.h"
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
@@ -7,46 +9,53 @@
 
 using namespace std;
 
-int main() {
+// Usage: ./main [workload file]   (keys from workload_gen instead of the
+//        default 10000 random 10-letter words)
+int main(int argc, char *argv[]) {
     const int NUM_WORDS = 10000;
     const int WORD_LENGTH = 10;
 
     cout << "=== Hash Table Demonstration Setup ===" << endl;
-    cout << "Generating " << NUM_WORDS << " unique " << WORD_LENGTH
-         << "-letter words..." << endl;
-
-    WordGenerator generator;
     vector<string> words;
-    words.reserve(NUM_WORDS);
-    for (int i = 0; i < NUM_WORDS; i++) {
-        words.push_back(generator.generateWord(WORD_LENGTH));
+    if (argc > 1) {
+        cout << "Reading words from " << argv[1] << "..." << endl;
+        words = readWorkload(argv[1]);
+    } else {
+        cout << "Generating " << NUM_WORDS << " unique " << WORD_LENGTH
+             << "-letter words..." << endl;
+        WorkloadSpec spec;
+        spec.count = NUM_WORDS;
+        spec.minLength = spec.maxLength = WORD_LENGTH;
+        words = generateKeys(spec).toStrings();
     }
-    cout << "Generated " << words.size() << " unique words." << endl << endl;
+    int numWords = words.size();
+    cout << "Using " << numWords << " words." << endl << endl;
 
     // --- PART A: Probe Sequence Demo [cite: 6] ---
     cout << "=== Probe Sequence Demo (Double Hashing) ===" << endl;
 
     // Create a table specifically for this demo using Double Hashing (Method 1)
     // and Hash Function 1
-    HashTable<int> demoTable(DOUBLE_HASHING, 1);
+    HashTable<string, int> demoTable(DOUBLE_HASHING, 1);
 
-    // Insert the 10,000 words [cite: 6]
+    // Insert the words [cite: 6]
     cout << "Inserting words into demo table..." << endl;
-    for (int i = 0; i < NUM_WORDS; i++) {
-        demoTable.insert(words[i], i + 1);
+    vector<int> values(numWords);
+    for (int i = 0; i < numWords; i++) {
+        values[i] = i + 1;
     }
+    demoTable.insertBatch(words.data(), values.data(), numWords);
     cout << "Insertion complete." << endl;
 
     // Interactive Input for Probe Sequence [cite: 7, 8, 9]
-    int n;
-    cout << "\nEnter number of keys to probe (n): ";
-    if (cin >> n) {
+    InputReader in; // stdin
+    int64_t n;
+    string_view key;
+    cout << "\nEnter number of keys to probe (n): " << flush;
+    if (in.nextInt(n)) {
         cout << "Enter " << n << " keys (one per line):" << endl;
-        for (int i = 0; i < n; i++) {
-            string key;
-            cin >> key;
-            demoTable.printProbeSequence(key);
-        }
+        for (int64_t i = 0; i < n && in.nextWord(key); i++)
+            demoTable.printProbeSequence(string(key));
     }
 
     return 0;
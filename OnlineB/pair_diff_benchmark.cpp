@@ -0,0 +1,105 @@
+#include "FrequencyMap.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Pair-difference counts for a batch of k: one pass of the serial
+// unordered_map loop (as count-pair-diff.cpp does it) per k, against one
+// partitioned FrequencyMap answering every k in a single pass. The counts
+// must agree exactly, one k at a time too, and 64-bit keys are checked at
+// the ends of their range.
+// Usage: ./pair_diff_benchmark [n] [range] [queries] [threads]
+//        (default: 10000000 1000000 16, one thread per hardware thread)
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double>(elapsed).count();
+}
+
+uint64_t serialCountPairs(const vector<int> &arr, int k) {
+    unordered_map<int, uint64_t> freq;
+    uint64_t count = 0;
+    for (int v : arr) {
+        auto it = freq.find(v + k);
+        if (it != freq.end())
+            count += it->second;
+        it = freq.find(v - k);
+        if (it != freq.end())
+            count += it->second;
+        freq[v]++;
+    }
+    return count;
+}
+
+// Differences at the ends of 64-bit key ranges, where key + |k| overflows
+bool checkWideKeys() {
+    const long long MAX = numeric_limits<long long>::max();
+    const long long MIN = numeric_limits<long long>::min();
+    FrequencyMap<uint64_t> unsignedKeys(vector<uint64_t>{1, 2, 3, 4, 5, 5});
+    FrequencyMap<int64_t> signedKeys(
+        vector<int64_t>{MAX, MAX - 1, MIN, MIN + 1, -1});
+    vector<uint64_t> counts = signedKeys.countPairs({1, MAX, MIN});
+    return unsignedKeys.countPairs(1) == 5 && counts[0] == 2 &&
+           counts[1] == 2 && counts[2] == 1;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = (argc > 1) ? atoll(argv[1]) : 10000000;
+    int range = (argc > 2) ? atoi(argv[2]) : 1000000;
+    int queries = (argc > 3) ? atoi(argv[3]) : 16;
+    int threads = workloadThreads((argc > 4) ? atoi(argv[4]) : 0);
+
+    uint64_t state = 42;
+    vector<int> arr(n);
+    for (int &v : arr)
+        v = splitMix64(state) % range;
+    vector<long long> ks(queries);
+    for (int i = 0; i < queries; i++)
+        ks[i] = (i == 0) ? 0 : splitMix64(state) % 1000;
+
+    cout << n << " values in [0, " << range << "), " << queries
+         << " queries, " << threads << " threads" << endl;
+
+    auto start = chrono::steady_clock::now();
+    vector<uint64_t> expected(queries);
+    for (int i = 0; i < queries; i++)
+        expected[i] = serialCountPairs(arr, ks[i]);
+    double serialSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    FrequencyMap<int> freq(arr, threads);
+    double buildSeconds = secondsSince(start);
+    start = chrono::steady_clock::now();
+    vector<uint64_t> counts = freq.countPairs(ks);
+    double querySeconds = secondsSince(start);
+
+    for (int i = 0; i < queries; i++)
+        if (counts[i] != expected[i] || freq.countPairs(ks[i]) != counts[i]) {
+            cout << "MISMATCH for k = " << ks[i] << ": " << counts[i]
+                 << " != " << expected[i] << endl;
+            return 1;
+        }
+    if (!checkWideKeys()) {
+        cout << "MISMATCH for 64-bit keys" << endl;
+        return 1;
+    }
+
+    cout << fixed << setprecision(3);
+    cout << "unordered_map, per k   " << setw(9) << serialSeconds << " s"
+         << endl;
+    cout << "FrequencyMap build     " << setw(9) << buildSeconds << " s  ("
+         << freq.partitionCount() << " partitions, " << freq.distinct()
+         << " distinct)" << endl;
+    cout << "FrequencyMap all k     " << setw(9) << querySeconds << " s"
+         << endl;
+    cout << "speedup " << setprecision(1)
+         << serialSeconds / (buildSeconds + querySeconds) << "x, counts match"
+         << endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "HashTable.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Compares the open addressing methods on random 10-letter words.
+// Usage: ./probing_benchmark [numWords...]   (default: 10000 10000000)
+//        (build with -DHASHTABLE_STATS to also print probe histograms)
+
+const int WORD_LENGTH = 10;
+
+// Words are drawn without deduplication (see Workload.h for unique keys);
+// the odd duplicate is simply rejected by insert.
+vector<string> randomWords(int count, mt19937 &gen) {
+    uniform_int_distribution<> dis(0, 25);
+    vector<string> words(count, string(WORD_LENGTH, 'a'));
+    for (auto &w : words)
+        for (auto &c : w)
+            c = char('a' + dis(gen));
+    return words;
+}
+
+double nsPerOp(chrono::steady_clock::time_point start, int ops) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double, nano>(elapsed).count() / ops;
+}
+
+template <typename K, typename Hash = KeyHash<K>>
+void benchmark(const char *name, CollisionMethod method,
+               const vector<K> &words, const vector<K> &missing,
+               SizePolicy sizes = PRIME_SIZES) {
+    HashTable<K, int, Hash> table(method, 1, false, sizes);
+    int n = words.size();
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        table.insert(words[i], i);
+    double insertNs = nsPerOp(start, n);
+
+    int value;
+    long long found = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        found += table.search(words[i], value);
+    double hitNs = nsPerOp(start, n);
+    double hitProbes = table.getAverageProbes();
+
+#ifdef HASHTABLE_STATS
+    StatsSnapshot beforeMisses = table.getStatsSnapshot();
+#endif
+    table.resetStatistics();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        found += table.search(missing[i], value);
+    double missNs = nsPerOp(start, n);
+    double missProbes = table.getAverageProbes();
+
+    cout << left << setw(16) << name << right << fixed << setprecision(1)
+         << setw(12) << insertNs << setw(12) << hitNs << setw(12) << missNs
+         << setprecision(2) << setw(12) << hitProbes << setw(12) << missProbes
+         << "   (" << found << " found)" << endl;
+#ifdef HASHTABLE_STATS
+    // Histograms of the lookups above, clusters of the final table
+    StatsSnapshot stats = table.getStatsSnapshot();
+    stats.hitProbes = beforeMisses.hitProbes;
+    stats.resizes = beforeMisses.resizes;
+    stats.resizeSeconds = beforeMisses.resizeSeconds;
+    stats.longestResizePause = beforeMisses.longestResizePause;
+    stats.print(cout);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(atoi(argv[i]));
+    if (sizes.empty())
+        sizes = {10000, 10000000};
+
+    mt19937 gen(42);
+    for (int n : sizes) {
+        vector<string> words = randomWords(n, gen);
+        // Upper-case keys can never collide with the inserted words
+        vector<string> missing = randomWords(n, gen);
+        for (auto &w : missing)
+            w[0] = 'A';
+
+        cout << "=== " << n << " words ===" << endl;
+        cout << left << setw(16) << "Method" << right << setw(12)
+             << "insert ns" << setw(12) << "hit ns" << setw(12) << "miss ns"
+             << setw(12) << "hit probes" << setw(12) << "miss probes" << endl;
+        benchmark("Double", DOUBLE_HASHING, words, missing);
+        benchmark("Custom", CUSTOM_PROBING, words, missing);
+        benchmark("Group (SIMD)", GROUP_PROBING, words, missing);
+        benchmark("Robin Hood", ROBIN_HOOD, words, missing);
+        benchmark("Cuckoo", CUCKOO_HASHING, words, missing);
+
+        // wyhash instead of the rolling hashes, and power-of-two sizes
+        // (mask instead of fastmod)
+        benchmark<string, WyHash>("Double/wy", DOUBLE_HASHING, words,
+                                  missing);
+        benchmark<string, WyHash>("Double/wy/pow2", DOUBLE_HASHING, words,
+                                  missing, POWER_OF_TWO_SIZES);
+        benchmark<string, WyHash>("Group/wy", GROUP_PROBING, words, missing);
+        benchmark<string, WyHash>("Group/wy/pow2", GROUP_PROBING, words,
+                                  missing, POWER_OF_TWO_SIZES);
+        benchmark<string, WyHash>("Robin/wy", ROBIN_HOOD, words, missing);
+        benchmark<string, WyHash>("Robin/wy/pow2", ROBIN_HOOD, words, missing,
+                                  POWER_OF_TWO_SIZES);
+        benchmark<string, WyHash>("Cuckoo/wy", CUCKOO_HASHING, words,
+                                  missing);
+
+        // Same workload with the keys stored inline
+        typedef FixedString<WORD_LENGTH> Key;
+        vector<Key> fixedWords(words.begin(), words.end());
+        vector<Key> fixedMissing(missing.begin(), missing.end());
+        vector<string>().swap(words);
+        vector<string>().swap(missing);
+        benchmark("Double/fixed", DOUBLE_HASHING, fixedWords, fixedMissing);
+        benchmark("Custom/fixed", CUSTOM_PROBING, fixedWords, fixedMissing);
+        benchmark("Group/fixed", GROUP_PROBING, fixedWords, fixedMissing);
+        benchmark("Robin/fixed", ROBIN_HOOD, fixedWords, fixedMissing);
+        benchmark("Cuckoo/fixed", CUCKOO_HASHING, fixedWords, fixedMissing);
+        cout << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "SetOperations.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Union / intersection / difference of two random ID sets that overlap by
+// about half: two chained HashTables and std::sort (the old onlineC.cpp)
+// against SetAlgebra with radix-sorted results, and with cardinalities only.
+// Usage: ./set_benchmark [keysPerSet] [threads]   (default: 10000000, all)
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double>(elapsed).count();
+}
+
+void printRow(const char *name, double seconds, uint64_t u, uint64_t i,
+              uint64_t d) {
+    cout << left << setw(20) << name << right << fixed << setprecision(3)
+         << setw(10) << seconds << setw(12) << u << setw(12) << i << setw(12)
+         << d << endl;
+}
+
+void benchmarkHashTables(const vector<long long> &a,
+                         const vector<long long> &b) {
+    auto start = chrono::steady_clock::now();
+    HashTable<long long, int> inA(CHAINING, 1), inB(CHAINING, 1);
+    vector<long long> unionKeys, intersection, difference;
+    for (long long k : a)
+        if (inA.insert(k, 1))
+            unionKeys.push_back(k);
+    for (long long k : b) {
+        if (!inB.insert(k, 1))
+            continue;
+        if (!inA.insert(k, 1))
+            intersection.push_back(k);
+        else
+            unionKeys.push_back(k);
+    }
+    int value;
+    for (long long k : a)
+        if (!inB.search(k, value) && inA.remove(k))
+            difference.push_back(k);
+    sort(unionKeys.begin(), unionKeys.end());
+    sort(intersection.begin(), intersection.end());
+    sort(difference.begin(), difference.end());
+    printRow("HashTable + sort", secondsSince(start), unionKeys.size(),
+             intersection.size(), difference.size());
+}
+
+void benchmarkSetAlgebra(const vector<long long> &a,
+                         const vector<long long> &b, int threads,
+                         bool countOnly) {
+    auto start = chrono::steady_clock::now();
+    SetAlgebra<long long> sets(threads);
+    sets.addA(a);
+    sets.addB(b);
+    if (countOnly) {
+        SetCardinalities c = sets.cardinalities();
+        printRow("SetAlgebra counts", secondsSince(start), c.unionSize,
+                 c.intersection, c.difference);
+        return;
+    }
+    SetResults<long long> r = sets.results();
+    printRow("SetAlgebra sorted", secondsSince(start), r.unionKeys.size(),
+             r.intersection.size(), r.difference.size());
+}
+
+int main(int argc, char *argv[]) {
+    long long n = (argc > 1) ? atoll(argv[1]) : 10000000;
+    int threads = workloadThreads((argc > 2) ? atoi(argv[2]) : 0);
+
+    // IDs below 2n: the sets share about half of their keys
+    uint64_t state = 42;
+    vector<long long> a(n), b(n);
+    for (long long i = 0; i < n; i++) {
+        a[i] = splitMix64(state) % (2 * n);
+        b[i] = splitMix64(state) % (2 * n);
+    }
+
+    cout << n << " keys per set, " << threads << " threads" << endl;
+    cout << left << setw(20) << "Method" << right << setw(10) << "seconds"
+         << setw(12) << "union" << setw(12) << "intersect" << setw(12)
+         << "A - B" << endl;
+    benchmarkHashTables(a, b);
+    benchmarkSetAlgebra(a, b, threads, false);
+    benchmarkSetAlgebra(a, b, threads, true);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "MappedHashTable.h"
+#include "Workload.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Rebuilding a table by inserting every key against mapping a saved
+// snapshot of it, for each collision method.
+// Usage: ./snapshot_benchmark [numKeys] [snapshot file]
+//        (default: 1000000 /tmp/hashtable.snap)
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double>(elapsed).count();
+}
+
+void benchmark(const char *name, CollisionMethod method,
+               const vector<string> &keys, const string &path) {
+    int n = keys.size();
+    auto start = chrono::steady_clock::now();
+    HashTable<string, int> table(method, 1);
+    for (int i = 0; i < n; i++)
+        table.insert(keys[i], i);
+    double buildSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    table.saveSnapshot(path);
+    double saveSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    MappedHashTable<string, int> mapped(path, method, 1);
+    double openSeconds = secondsSince(start);
+
+    // The first lookups pay for reading their pages in
+    int value;
+    long long found = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        found += mapped.search(keys[i], value);
+    double searchSeconds = secondsSince(start);
+
+    cout << left << setw(10) << name << right << fixed << setprecision(3)
+         << setw(11) << buildSeconds * 1e3 << setw(11) << saveSeconds * 1e3
+         << setw(11) << openSeconds * 1e3 << setprecision(1) << setw(14)
+         << searchSeconds * 1e9 / n << "   (" << found << " found)" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    WorkloadSpec spec;
+    spec.count = (argc > 1) ? atoll(argv[1]) : 1000000;
+    string path = (argc > 2) ? argv[2] : "/tmp/hashtable.snap";
+    vector<string> keys = generateKeys(spec).toStrings();
+
+    cout << keys.size() << " keys" << endl;
+    cout << left << setw(10) << "Method" << right << setw(11) << "build ms"
+         << setw(11) << "save ms" << setw(11) << "open ms" << setw(14)
+         << "mapped ns/op" << endl;
+    benchmark("Chaining", CHAINING, keys, path);
+    benchmark("Double", DOUBLE_HASHING, keys, path);
+    benchmark("Custom", CUSTOM_PROBING, keys, path);
+    benchmark("Group", GROUP_PROBING, keys, path);
+    benchmark("Robin", ROBIN_HOOD, keys, path);
+    benchmark("Cuckoo", CUCKOO_HASHING, keys, path);
+    return 0;
+}
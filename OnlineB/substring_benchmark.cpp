@@ -0,0 +1,88 @@
+#include "SuffixArray.h"
+#include "Workload.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Distinct substring counts of random strings: the suffix trie that
+// distinct-substr.cpp used to build (26 child pointers per node, O(n^2)
+// nodes), up to a length it can still hold, against the suffix array and
+// LCP array. Both counts must agree where both run.
+// Usage: ./substring_benchmark [maxLength] [alphabet] [trieLimit]
+//        (default: 10000000 4 2000)
+
+struct TrieNode {
+    TrieNode *child[26] = {};
+};
+
+uint64_t trieCount(const string &s, size_t &nodes) {
+    vector<TrieNode *> all{new TrieNode()};
+    uint64_t count = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        TrieNode *node = all[0];
+        for (size_t j = i; j < s.size(); j++) {
+            TrieNode *&next = node->child[s[j] - 'a'];
+            if (next == nullptr) {
+                next = new TrieNode();
+                all.push_back(next);
+                count++;
+            }
+            node = next;
+        }
+    }
+    nodes = all.size();
+    for (TrieNode *node : all)
+        delete node;
+    return count;
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double>(elapsed).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t maxLength = (argc > 1) ? atoll(argv[1]) : 10000000;
+    int alphabet = (argc > 2) ? atoi(argv[2]) : 4;
+    size_t trieLimit = (argc > 3) ? atoll(argv[3]) : 2000;
+    alphabet = max(1, min(alphabet, 26));
+
+    cout << "alphabet " << alphabet << endl;
+    cout << right << setw(10) << "length" << setw(18) << "distinct"
+         << setw(12) << "trie s" << setw(12) << "trie MiB" << setw(12)
+         << "SA s" << endl;
+    uint64_t state = 42;
+    for (size_t n = 1000; n <= maxLength; n *= 10) {
+        string s(n, 'a');
+        for (char &c : s)
+            c = 'a' + splitMix64(state) % alphabet;
+
+        auto start = chrono::steady_clock::now();
+        uint64_t count = countDistinctSubstrings(s);
+        double saSeconds = secondsSince(start);
+
+        cout << setw(10) << n << setw(18) << count << fixed;
+        if (n <= trieLimit) {
+            size_t nodes;
+            start = chrono::steady_clock::now();
+            uint64_t expected = trieCount(s, nodes);
+            double trieSeconds = secondsSince(start);
+            if (expected != count) {
+                cout << endl << "MISMATCH: trie counts " << expected << endl;
+                return 1;
+            }
+            cout << setprecision(3) << setw(12) << trieSeconds
+                 << setprecision(1) << setw(12)
+                 << nodes * sizeof(TrieNode) / 1048576.0;
+        } else {
+            cout << setw(12) << "-" << setw(12) << "-";
+        }
+        cout << setprecision(3) << setw(12) << saSeconds << endl;
+    }
+    return 0;
+}
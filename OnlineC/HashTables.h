@@ -0,0 +1,481 @@
+#ifndef ONLINEC_HASHTABLES_H
+#define ONLINEC_HASHTABLES_H
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <functional>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "../OnlineB/HashFunctions.h"
+using namespace std;
+
+// The OnlineC tables have names of their own (Entry, isPrime, ...) that the
+// OnlineB headers use too, so both can be included by one program
+namespace onlinec {
+
+// ---------------- CONFIG ----------------
+// inline: this header is included by more than one translation unit
+inline int INITIAL_SIZE = 13;
+inline double LOAD_FACTOR_UPPER = 0.5;
+inline double LOAD_FACTOR_LOWER = 0.25;
+const int BATCH_GROUP = 16; // keys hashed+prefetched together by searchBatch
+// HashTableCustom::insert takes a slot among the first
+// PROBE_LIMIT_FACTOR/(1-LOAD_FACTOR_UPPER) probes, or grows the table
+const int PROBE_LIMIT_FACTOR = 16;
+// ... and gives up after growing this many more times for one key
+const int MAX_INSERT_EXPANSIONS = 8;
+
+// ---------------- PRIME UTILS ----------------
+inline bool isPrime(int n){
+    if(n<=1) return false;
+    if(n<=3) return true;
+    if(n%2==0||n%3==0) return false;
+    for(int i=5;i*i<=n;i+=6)
+        if(n%i==0||n%(i+2)==0) return false;
+    return true;
+}
+inline int nextPrime(int n){ while(!isPrime(n)) n++; return n; }
+inline int prevPrime(int n){ n=max(2,n); while(!isPrime(n)) n--; return n; }
+
+// ---------------- HASH FUNCTIONS ----------------
+inline size_t polyHash(const string &s, size_t p=31, size_t mod=1e9+9){
+    size_t hash=0,power=1;
+    for(char c:s){
+        hash=(hash+(c-'a'+1)*power)%mod;
+        power=(power*p)%mod;
+    }
+    return hash;
+}
+
+inline size_t djb2Hash(const string &s){
+    size_t hash=5381;
+    for(char c:s) hash=((hash<<5)+hash)+c;
+    return hash;
+}
+
+// Hasher types for the tables below. The hasher is a template parameter, so
+// the call is resolved (and usually inlined) at compile time.
+struct PolyHasher{
+    size_t operator()(const string &s) const { return polyHash(s); }
+};
+struct Djb2Hasher{
+    size_t operator()(const string &s) const { return djb2Hash(s); }
+};
+// 64-bit wyhash, 8 bytes per step instead of one
+struct WyHasher{
+    size_t operator()(const string &s) const { return wyHash(s.data(),s.size()); }
+};
+
+// ---------------- AUX HASH ----------------
+// Template specialization for string
+template<typename K>
+size_t auxHashImpl(const K &key, size_t tableSize){
+    size_t h=hash<K>{}(key);
+    return 1 + (h % (tableSize-1));
+}
+
+// Overload for string
+inline size_t auxHash(const string &key, size_t tableSize){
+    size_t h=hash<string>{}(key);
+    return 1 + (h % (tableSize-1));
+}
+
+// Template version for other types
+template<typename K>
+size_t auxHash(const K &key, size_t tableSize){
+    return auxHashImpl(key, tableSize);
+}
+
+// ---------------- KEY TO STRING ----------------
+inline const string &keyToString(const string &s){ return s; }
+template<typename K>
+inline string keyToString(const K &key){ return to_string(key); }
+
+// ---------------- ENTRY ----------------
+template<typename K,typename V>
+struct Entry{
+    K key;
+    V value;
+    Entry(K k,V v):key(k),value(v){}
+};
+
+// ---------------- RANDOM WORD GENERATOR ----------------
+inline string generateWord(int len, mt19937 &rng){
+    uniform_int_distribution<int> dist('a','z');
+    string w;
+    for(int i=0;i<len;i++) w+=(char)dist(rng);
+    return w;
+}
+
+// ---------------- CHAINING ----------------
+template<typename K,typename V,typename Hasher=PolyHasher>
+class HashTableChaining{
+    Hasher hashFunc;
+public:
+    int size,nElements,lastExpansion,lastCompaction;
+    vector<list<Entry<K,V>>> table;
+    int collisionCount;
+
+    HashTableChaining(int s=INITIAL_SIZE,const Hasher &h=Hasher()): hashFunc(h) {
+        size=s; nElements=0;
+        collisionCount=0;
+        table.resize(size);
+        lastExpansion=lastCompaction=0;
+    }
+
+    void adjustSize(){
+        double lf=(double)nElements/size;
+        if(lf>LOAD_FACTOR_UPPER && nElements-lastExpansion>=size/2) expand();
+        else if(lf<LOAD_FACTOR_LOWER && nElements-lastCompaction>=size/2) compact();
+    }
+    void expand(){ rehash(nextPrime(size*2+1)); lastExpansion=nElements; }
+    void compact(){ if(size!=INITIAL_SIZE){ rehash(prevPrime(size/2)); lastCompaction=nElements; } }
+
+    void rehash(int newSize){
+        auto old=table;
+        table.clear(); table.resize(newSize);
+        size=newSize; nElements=0;
+        for(auto &bucket:old)
+            for(auto &e:bucket)
+                insert(e.key,e.value);
+    }
+
+    bool insert(const K &key,const V &value){
+        size_t idx=hashFunc(keyToString(key))%size;
+        for(auto &e:table[idx])
+            if(e.key==key) return false;
+        collisionCount+=table[idx].size();
+        table[idx].emplace_back(key,value);
+        nElements++;
+        adjustSize();
+        return true;
+    }
+
+    V search(const K &key,int &hits){
+        return searchAt(key,hashFunc(keyToString(key))%size,hits);
+    }
+
+    V searchAt(const K &key,size_t idx,int &hits){
+        hits=0;
+        for(auto &e:table[idx]){
+            hits++;
+            if(e.key==key) return e.value;
+        }
+        return V();
+    }
+
+    // search() for count keys. A group of keys is hashed and its buckets
+    // (then first nodes) prefetched before any is resolved, so the cache
+    // misses overlap instead of stalling one lookup at a time
+    void searchBatch(const K *keys,int count,V *values,int *hits){
+        size_t idx[BATCH_GROUP];
+        for(int s=0;s<count;s+=BATCH_GROUP){
+            int n=min(BATCH_GROUP,count-s);
+            for(int i=0;i<n;i++){
+                idx[i]=hashFunc(keyToString(keys[s+i]))%size;
+                __builtin_prefetch(&table[idx[i]]);
+            }
+            for(int i=0;i<n;i++)
+                if(!table[idx[i]].empty()) __builtin_prefetch(&table[idx[i]].front());
+            for(int i=0;i<n;i++) values[s+i]=searchAt(keys[s+i],idx[i],hits[s+i]);
+        }
+    }
+
+    bool remove(const K &key){
+        size_t idx=hashFunc(keyToString(key))%size;
+        for(auto it=table[idx].begin();it!=table[idx].end();++it){
+            if(it->key==key){
+                table[idx].erase(it);
+                nElements--;
+                adjustSize();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// ---------------- DOUBLE HASHING ----------------
+template<typename K,typename V,typename Hasher=PolyHasher>
+class HashTableDouble{
+    Hasher hashFunc;
+public:
+    int size,nElements,lastExpansion,lastCompaction,collisionCount;
+    vector<Entry<K,V>*> table;
+    vector<bool> deleted;
+
+    HashTableDouble(int s=INITIAL_SIZE,const Hasher &h=Hasher()): hashFunc(h) {
+        size=s;nElements=0;
+        collisionCount=0;
+        table.resize(size,nullptr);
+        deleted.resize(size,false);
+        lastExpansion=lastCompaction=0;
+    }
+    // The table owns its entries; a removed one is freed when its slot is
+    // reused or the table rehashed
+    ~HashTableDouble(){ for(auto e:table) delete e; }
+    HashTableDouble(const HashTableDouble&)=delete;
+    HashTableDouble &operator=(const HashTableDouble&)=delete;
+
+    void adjustSize(){
+        double lf=(double)nElements/size;
+        //cout<<lf<<endl;
+        if(lf>LOAD_FACTOR_UPPER && nElements-lastExpansion>=size/2) expand();
+        else if(lf<LOAD_FACTOR_LOWER && nElements-lastCompaction>=size/2) compact();
+    }
+
+    void expand(){ rehash(nextPrime(size*2+1)); lastExpansion=nElements; }
+    void compact(){ if(size!=INITIAL_SIZE){ rehash(prevPrime(size/2)); lastCompaction=nElements; } }
+
+    void rehash(int newSize){
+        auto old=table; auto oldDel=deleted;
+        table.clear(); deleted.clear();
+        table.resize(newSize,nullptr); deleted.resize(newSize,false);
+        size=newSize; nElements=0;
+        //cout<<"Current size:"<<size<<endl;
+
+        for(int i=0;i<(int)old.size();i++){
+            if(old[i] && !oldDel[i]) insert(old[i]->key,old[i]->value);
+            delete old[i];
+        }
+    }
+
+    bool insert(const K &key,const V &value){
+        size_t h1=hashFunc(keyToString(key))%size;
+        size_t h2=auxHash(key,size);
+        int firstdel = -1;
+        for(int i=0;i<size;i++){
+            size_t idx=(h1+i*h2)%size;
+            if(deleted[idx]){
+                if(table[idx] && firstdel == -1) { 
+                    firstdel = idx;
+                }
+            }
+            if(!table[idx] && !deleted[idx]){
+                if(firstdel != -1) idx = firstdel;
+                delete table[idx];
+                table[idx]=new Entry<K,V>(key,value);
+                deleted[idx]=false;
+                nElements++;
+                adjustSize();
+                return true;
+            } 
+            else if(table[idx] && table[idx]->key==key) return false;
+            collisionCount++;
+        }
+        return false;
+    }
+
+    V search(const K &key,int &hits){
+        return searchAt(key,hashFunc(keyToString(key))%size,auxHash(key,size),hits);
+    }
+
+    V searchAt(const K &key,size_t h1,size_t h2,int &hits){
+        hits=0;
+        for(int i=0;i<size;i++){
+            size_t idx=(h1+i*h2)%size;
+            hits++;
+            if(!table[idx] && !deleted[idx]) return V();
+            if(table[idx] && !deleted[idx] && table[idx]->key==key) return table[idx]->value;
+        }
+        return V();
+    }
+
+    // search() for count keys: a group is hashed and its first slots (then
+    // entries) prefetched before any key is resolved
+    void searchBatch(const K *keys,int count,V *values,int *hits){
+        size_t h1[BATCH_GROUP],h2[BATCH_GROUP];
+        for(int s=0;s<count;s+=BATCH_GROUP){
+            int n=min(BATCH_GROUP,count-s);
+            for(int i=0;i<n;i++){
+                h1[i]=hashFunc(keyToString(keys[s+i]))%size;
+                h2[i]=auxHash(keys[s+i],size);
+                __builtin_prefetch(&table[h1[i]]);
+            }
+            for(int i=0;i<n;i++) if(table[h1[i]]) __builtin_prefetch(table[h1[i]]);
+            for(int i=0;i<n;i++) values[s+i]=searchAt(keys[s+i],h1[i],h2[i],hits[s+i]);
+        }
+    }
+
+    bool remove(const K &key){
+        size_t h1=hashFunc(keyToString(key))%size;
+        size_t h2=auxHash(key,size);
+        for(int i=0;i<size;i++){
+            size_t idx=(h1+i*h2)%size;
+            if(!table[idx] && !deleted[idx]) return false;
+            if(table[idx] && !deleted[idx] && table[idx]->key==key){
+                deleted[idx]=true;
+                nElements--;
+                adjustSize();
+                return true;
+            }
+        }
+        return false;
+    }
+    void printProbeSequence(const K &key, int &hits){
+        size_t h1=hashFunc(keyToString(key))%size;
+        size_t h2=auxHash(key,size);
+        hits=0;
+        vector<long long> probes;
+        for(int i=0;i<size;i++){
+            size_t idx=(h1+i*h2)%size;
+            hits++;
+            probes.push_back(idx);
+            if(!table[idx] && !deleted[idx]) break;
+            if(table[idx] && !deleted[idx] && table[idx]->key==key) break;
+        }
+        if(probes.size()==0) return;
+        for(long long i=0; i<probes.size()-1; i++) cout<<probes[i]<<"->";
+        cout<<probes[probes.size()-1]<<endl;
+    }
+        
+};
+
+// ---------------- CUSTOM PROBING ----------------
+template<typename K,typename V,typename Hasher=PolyHasher>
+class HashTableCustom{
+    int C1,C2;
+    Hasher hashFunc;
+    enum InsertResult{INSERTED,DUPLICATE,NO_FREE_SLOT};
+public:
+    int size,nElements,lastExpansion,lastCompaction,collisionCount;
+    int retriedInserts; // no free slot within probeLimit(), placed later
+    int longestProbe;  // highest probe number an entry was placed at
+    vector<Entry<K,V>*> table;
+    vector<bool> deleted;
+
+    HashTableCustom(int c1,int c2,int s=INITIAL_SIZE,const Hasher &h=Hasher()): C1(c1), C2(c2), hashFunc(h) {
+        size=s;nElements=0;
+        collisionCount=retriedInserts=longestProbe=0;
+        table.resize(size,nullptr);
+        deleted.resize(size,false);
+        lastExpansion=lastCompaction=0;
+    }
+    ~HashTableCustom(){ for(auto e:table) delete e; }
+    HashTableCustom(const HashTableCustom&)=delete;
+    HashTableCustom &operator=(const HashTableCustom&)=delete;
+
+    void adjustSize(){
+        double lf=(double)nElements/size;
+        if(lf>LOAD_FACTOR_UPPER && nElements-lastExpansion>=size/2) expand();
+        else if(lf<LOAD_FACTOR_LOWER && nElements-lastCompaction>=size/2) compact();
+    }
+    void expand(){ rehash(nextPrime(size*2+1)); lastExpansion=nElements; }
+    void compact(){ if(size!=INITIAL_SIZE){ rehash(prevPrime(size/2)); lastCompaction=nElements; } }
+
+    void rehash(int newSize){
+        auto old=table; auto oldDel=deleted;
+        table.clear(); deleted.clear();
+        table.resize(newSize,nullptr); deleted.resize(newSize,false);
+        size=newSize;nElements=0;longestProbe=0;
+        for(int i=0;i<(int)old.size();i++){
+            if(old[i] && !oldDel[i]) insert(old[i]->key,old[i]->value);
+            delete old[i];
+        }
+    }
+
+    int probeLimit(){ return min(size,(int)(PROBE_LIMIT_FACTOR/(1-LOAD_FACTOR_UPPER))+1); }
+
+    // The quadratic sequence on a prime size reaches only about half of the
+    // slots, and a crowded one takes many probes to find a free slot. Past
+    // probeLimit() the table grows (unless it is nearly empty) and the key
+    // may then take any free slot of its sequence; while there is none the
+    // table keeps growing, so false always means a duplicate key. Below
+    // half full the sequence is sure to reach a free slot unless C1 and C2
+    // make it degenerate, which throws rather than grow forever.
+    bool insert(const K &key,const V &value){
+        InsertResult r=tryInsert(key,value,probeLimit());
+        if(r==NO_FREE_SLOT){
+            retriedInserts++;
+            if((double)nElements/size>LOAD_FACTOR_LOWER) expand();
+            r=tryInsert(key,value,size);
+            for(int grown=0;r==NO_FREE_SLOT;grown++){
+                if(grown==MAX_INSERT_EXPANSIONS)
+                    throw runtime_error("HashTableCustom: no free slot for key");
+                expand(); r=tryInsert(key,value,size);
+            }
+        }
+        if(r!=INSERTED) return false;
+        nElements++;
+        adjustSize();
+        return true;
+    }
+
+    // Takes the first free slot among the first limit probes. Duplicates
+    // are looked for up to the first empty slot or longestProbe.
+    InsertResult tryInsert(const K &key,const V &value,int limit){
+        size_t h1=hashFunc(keyToString(key))%size;
+        size_t h2=auxHash(key,size);
+        int freeIdx=-1,freeProbe=0;
+        int scan=max(limit,longestProbe+1);
+        for(int i=0;i<scan;i++){
+            size_t idx=(h1+C1*i*h2+C2*(size_t)i*i)%size;
+            bool empty=!table[idx] && !deleted[idx];
+            if(freeIdx==-1 && i<limit && (empty || deleted[idx])){ freeIdx=idx; freeProbe=i; }
+            if(empty) break;
+            if(!deleted[idx] && table[idx]->key==key) return DUPLICATE;
+            collisionCount++;
+        }
+        if(freeIdx==-1) return NO_FREE_SLOT;
+        delete table[freeIdx];
+        table[freeIdx]=new Entry<K,V>(key,value);
+        deleted[freeIdx]=false;
+        longestProbe=max(longestProbe,freeProbe);
+        return INSERTED;
+    }
+
+    V search(const K &key,int &hits){
+        return searchAt(key,hashFunc(keyToString(key))%size,auxHash(key,size),hits);
+    }
+
+    V searchAt(const K &key,size_t h1,size_t h2,int &hits){
+        hits=0;
+        for(int i=0;i<=longestProbe;i++){
+            size_t idx=(h1+C1*i*h2+C2*(size_t)i*i)%size;
+            hits++;
+            if(!table[idx] && !deleted[idx]) return V();
+            if(table[idx] && !deleted[idx] && table[idx]->key==key) return table[idx]->value;
+        }
+        return V();
+    }
+
+    // search() for count keys: a group is hashed and its first slots (then
+    // entries) prefetched before any key is resolved
+    void searchBatch(const K *keys,int count,V *values,int *hits){
+        size_t h1[BATCH_GROUP],h2[BATCH_GROUP];
+        for(int s=0;s<count;s+=BATCH_GROUP){
+            int n=min(BATCH_GROUP,count-s);
+            for(int i=0;i<n;i++){
+                h1[i]=hashFunc(keyToString(keys[s+i]))%size;
+                h2[i]=auxHash(keys[s+i],size);
+                __builtin_prefetch(&table[h1[i]]);
+            }
+            for(int i=0;i<n;i++) if(table[h1[i]]) __builtin_prefetch(table[h1[i]]);
+            for(int i=0;i<n;i++) values[s+i]=searchAt(keys[s+i],h1[i],h2[i],hits[s+i]);
+        }
+    }
+
+    bool remove(const K &key){
+        size_t h1=hashFunc(keyToString(key))%size;
+        size_t h2=auxHash(key,size);
+        for(int i=0;i<=longestProbe;i++){
+            size_t idx=(h1+C1*i*h2+C2*(size_t)i*i)%size;
+            if(!table[idx] && !deleted[idx]) return false;
+            if(table[idx] && !deleted[idx] && table[idx]->key==key){
+                deleted[idx]=true;
+                nElements--;
+                adjustSize();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace onlinec
+
+#endif // ONLINEC_HASHTABLES_H
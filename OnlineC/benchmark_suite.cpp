@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../OnlineB/HashTable.h"
+#include "HashTables.h"
+using namespace std;
+
+// Times insert, successful search, failed search and remove for every table
+// (OnlineB HashTable methods, OnlineC Chaining/Double/Custom) over a sweep of
+// key counts, maximum load factors, key lengths and hash functions.
+// Each configuration runs warmup + repetition samples on fresh tables; a
+// sample repeats small tables until it covers MIN_OPS_PER_SAMPLE operations.
+// Results: mean ns/op with a 95% confidence interval, ops/sec, and optional
+// CSV / JSON files for comparing builds.
+//
+// Usage: ./benchmark_suite [--sizes 1000,10000,...] [--loads 0.25,0.5]
+//          [--keylens 8,32] [--hashes poly,djb2,wyhash]
+//          [--tables B.chaining,B.double,B.custom,B.group,B.robin,B.cuckoo,C.chaining,C.double,C.custom]
+//          [--reps 5] [--warmup 1] [--seed 42] [--label name]
+//          [--csv file] [--json file]
+// Sizes up to 100000000 are accepted; 100M keys need about 10 GB.
+
+const int MIN_OPS_PER_SAMPLE=200000;
+const char *OP_NAMES[]={"insert","search_hit","search_miss","remove"};
+enum Op{INSERT,SEARCH_HIT,SEARCH_MISS,REMOVE,OP_COUNT};
+volatile long long sink;
+
+struct Options{
+    vector<long long> sizes={1000,10000,100000,1000000};
+    vector<double> loads={0.25,0.5};
+    vector<int> keyLengths={8,32};
+    vector<string> hashes={"poly","djb2","wyhash"};
+    vector<string> tables={"B.chaining","B.double","B.custom","B.group","B.robin","B.cuckoo",
+                           "C.chaining","C.double","C.custom"};
+    int reps=5,warmup=1;
+    unsigned seed=42;
+    string label="default",csvPath,jsonPath;
+};
+
+struct Keys{
+    vector<string> keys;    // inserted, in insertion order
+    vector<string> hits;    // the same keys, shuffled
+    vector<string> misses;  // never inserted (upper-case first letter)
+    vector<int> values;     // i + 1, so 0 can mean "not found"
+};
+
+struct Result{
+    string table,hash;
+    long long keys;
+    double targetLoad,actualLoad;
+    int keyLength;
+    Op op;
+    vector<double> ns; // one entry per repetition
+    long long inserted;
+};
+
+// ---------------- STATISTICS ----------------
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom
+const double T95[]={12.706,4.303,3.182,2.776,2.571,2.447,2.365,2.306,2.262,2.228,
+                    2.201,2.179,2.160,2.145,2.131,2.120,2.110,2.101,2.093,2.086,
+                    2.080,2.074,2.069,2.064,2.060,2.056,2.052,2.048,2.045,2.042};
+
+double mean(const vector<double> &v){
+    double s=0; for(double x:v) s+=x;
+    return s/v.size();
+}
+double stddev(const vector<double> &v){
+    if(v.size()<2) return 0;
+    double m=mean(v),s=0;
+    for(double x:v) s+=(x-m)*(x-m);
+    return sqrt(s/(v.size()-1));
+}
+double ci95(const vector<double> &v){
+    int df=v.size()-1;
+    if(df<1) return 0;
+    double t=(df<=30)?T95[df-1]:1.96;
+    return t*stddev(v)/sqrt((double)v.size());
+}
+
+// ---------------- TABLE ADAPTERS ----------------
+// OnlineB reports found/not found; OnlineC returns V() for a missing key
+template<typename H>
+bool lookup(HashTable<string,int,H> &t,const string &key,int &value){ return t.search(key,value); }
+template<typename T>
+bool lookup(T &t,const string &key,int &value){ int hits; value=t.search(key,hits); return value!=0; }
+
+template<typename K,typename V,typename H>
+double loadOf(const HashTable<K,V,H> &t){ return t.getLoadFactor(); }
+template<typename T>
+double loadOf(const T &t){ return (double)t.nElements/t.size; }
+
+double elapsedNs(chrono::steady_clock::time_point start){
+    return chrono::duration<double,nano>(chrono::steady_clock::now()-start).count();
+}
+
+// Runs warmup + reps samples of every operation on tables from make()
+template<typename Table,typename Make>
+void measure(const Options &opt,const Keys &k,Make make,Result proto,vector<Result> &results){
+    long long n=k.keys.size();
+    int rounds=max<long long>(1,MIN_OPS_PER_SAMPLE/n);
+    vector<Result> byOp(OP_COUNT,proto);
+    for(int op=0;op<OP_COUNT;op++) byOp[op].op=(Op)op;
+
+    for(int rep=-opt.warmup;rep<opt.reps;rep++){
+        double total[OP_COUNT]={0,0,0,0};
+        long long found=0,inserted=0;
+        double load=0;
+        for(int r=0;r<rounds;r++){
+            unique_ptr<Table> t=make();
+            auto start=chrono::steady_clock::now();
+            for(long long i=0;i<n;i++) inserted+=t->insert(k.keys[i],k.values[i]);
+            total[INSERT]+=elapsedNs(start);
+            load=loadOf(*t);
+
+            int value;
+            start=chrono::steady_clock::now();
+            for(long long i=0;i<n;i++) found+=lookup(*t,k.hits[i],value);
+            total[SEARCH_HIT]+=elapsedNs(start);
+
+            start=chrono::steady_clock::now();
+            for(long long i=0;i<n;i++) found+=lookup(*t,k.misses[i],value);
+            total[SEARCH_MISS]+=elapsedNs(start);
+
+            start=chrono::steady_clock::now();
+            for(long long i=0;i<n;i++) t->remove(k.hits[i]);
+            total[REMOVE]+=elapsedNs(start);
+        }
+        if(rep<0) continue; // warmup
+        for(int op=0;op<OP_COUNT;op++){
+            byOp[op].ns.push_back(total[op]/((double)rounds*n));
+            byOp[op].actualLoad=load;
+            byOp[op].inserted=inserted/rounds;
+        }
+        sink+=found; // keep the lookups
+    }
+    for(auto &r:byOp){
+        cout<<left<<setw(12)<<r.table<<setw(8)<<r.hash<<right<<setw(11)<<r.keys
+            <<fixed<<setprecision(2)<<setw(7)<<r.targetLoad<<setw(7)<<r.actualLoad
+            <<setw(5)<<r.keyLength<<"  "<<left<<setw(12)<<OP_NAMES[r.op]<<right
+            <<setprecision(1)<<setw(10)<<mean(r.ns)<<" +-"<<setw(7)<<ci95(r.ns)
+            <<setprecision(2)<<setw(10)<<1e3/mean(r.ns)<<"\n";
+        results.push_back(r);
+    }
+}
+
+// ---------------- CONFIGURATIONS ----------------
+template<typename Hash>
+void runB(const Options &opt,const Keys &k,CollisionMethod m,int hashType,double load,Result proto,vector<Result> &results){
+    typedef HashTable<string,int,Hash> Table;
+    measure<Table>(opt,k,[&]{
+        unique_ptr<Table> t(new Table(m,hashType));
+        t->setMaxLoadFactor(load);
+        return t;
+    },proto,results);
+}
+
+template<typename Hasher>
+void runC(const Options &opt,const Keys &k,const string &kind,double load,Result proto,vector<Result> &results){
+    // The OnlineC thresholds are globals; shrink below half the maximum,
+    // as with the defaults (0.5 / 0.25)
+    double upper=onlinec::LOAD_FACTOR_UPPER,lower=onlinec::LOAD_FACTOR_LOWER;
+    onlinec::LOAD_FACTOR_UPPER=load; onlinec::LOAD_FACTOR_LOWER=load/2;
+    if(kind=="chaining"){
+        typedef onlinec::HashTableChaining<string,int,Hasher> Table;
+        measure<Table>(opt,k,[]{ return unique_ptr<Table>(new Table()); },proto,results);
+    }else if(kind=="double"){
+        typedef onlinec::HashTableDouble<string,int,Hasher> Table;
+        measure<Table>(opt,k,[]{ return unique_ptr<Table>(new Table()); },proto,results);
+    }else{
+        typedef onlinec::HashTableCustom<string,int,Hasher> Table;
+        measure<Table>(opt,k,[]{ return unique_ptr<Table>(new Table(C1,C2)); },proto,results);
+    }
+    onlinec::LOAD_FACTOR_UPPER=upper; onlinec::LOAD_FACTOR_LOWER=lower;
+}
+
+// OnlineB: poly and djb2 are the two KeyHash rolling hashes (hash type 1/2)
+void runConfig(const Options &opt,const Keys &k,const string &table,const string &hash,double load,Result proto,vector<Result> &results){
+    string family=table.substr(0,1),kind=table.substr(2);
+    if(family=="B"){
+        CollisionMethod m=kind=="chaining"?CHAINING:kind=="double"?DOUBLE_HASHING:
+                          kind=="custom"?CUSTOM_PROBING:kind=="group"?GROUP_PROBING:
+                          kind=="robin"?ROBIN_HOOD:CUCKOO_HASHING;
+        if(hash=="wyhash") runB<WyHash>(opt,k,m,1,load,proto,results);
+        else runB<KeyHash<string>>(opt,k,m,hash=="poly"?1:2,load,proto,results);
+    }else{
+        if(hash=="poly") runC<onlinec::PolyHasher>(opt,k,kind,load,proto,results);
+        else if(hash=="djb2") runC<onlinec::Djb2Hasher>(opt,k,kind,load,proto,results);
+        else runC<onlinec::WyHasher>(opt,k,kind,load,proto,results);
+    }
+}
+
+Keys makeKeys(long long n,int len,mt19937 &rng){
+    Keys k;
+    uniform_int_distribution<int> dist('a','z');
+    k.keys.assign(n,string(len,'a'));
+    for(auto &w:k.keys) for(auto &c:w) c=(char)dist(rng);
+    k.hits=k.keys;
+    shuffle(k.hits.begin(),k.hits.end(),rng);
+    k.misses=k.hits;
+    for(auto &w:k.misses) w[0]=(char)toupper(w[0]);
+    k.values.resize(n);
+    for(long long i=0;i<n;i++) k.values[i]=(int)(i+1);
+    return k;
+}
+
+// ---------------- OUTPUT ----------------
+void writeCsv(const string &path,const Options &opt,const vector<Result> &results){
+    ofstream out(path);
+    out<<"label,table,hash,keys,target_load,actual_load,key_length,operation,"
+         "repetitions,mean_ns,stddev_ns,ci95_ns,min_ns,ops_per_sec,inserted\n";
+    for(auto &r:results)
+        out<<opt.label<<","<<r.table<<","<<r.hash<<","<<r.keys<<","<<r.targetLoad<<","
+           <<r.actualLoad<<","<<r.keyLength<<","<<OP_NAMES[r.op]<<","<<r.ns.size()<<","
+           <<mean(r.ns)<<","<<stddev(r.ns)<<","<<ci95(r.ns)<<","
+           <<*min_element(r.ns.begin(),r.ns.end())<<","<<1e9/mean(r.ns)<<","<<r.inserted<<"\n";
+}
+
+void writeJson(const string &path,const Options &opt,const vector<Result> &results){
+    ofstream out(path);
+    out<<"{\n  \"label\": \""<<opt.label<<"\",\n  \"repetitions\": "<<opt.reps
+       <<",\n  \"warmup\": "<<opt.warmup<<",\n  \"seed\": "<<opt.seed<<",\n  \"results\": [\n";
+    for(size_t i=0;i<results.size();i++){
+        const Result &r=results[i];
+        out<<"    {\"table\": \""<<r.table<<"\", \"hash\": \""<<r.hash<<"\", \"keys\": "<<r.keys
+           <<", \"target_load\": "<<r.targetLoad<<", \"actual_load\": "<<r.actualLoad
+           <<", \"key_length\": "<<r.keyLength<<", \"operation\": \""<<OP_NAMES[r.op]
+           <<"\", \"mean_ns\": "<<mean(r.ns)<<", \"stddev_ns\": "<<stddev(r.ns)
+           <<", \"ci95_ns\": "<<ci95(r.ns)<<", \"ops_per_sec\": "<<1e9/mean(r.ns)
+           <<", \"inserted\": "<<r.inserted<<", \"samples_ns\": [";
+        for(size_t j=0;j<r.ns.size();j++) out<<(j?", ":"")<<r.ns[j];
+        out<<"]}"<<(i+1<results.size()?",":"")<<"\n";
+    }
+    out<<"  ]\n}\n";
+}
+
+// ---------------- ARGUMENTS ----------------
+vector<string> splitList(const string &s){
+    vector<string> parts;
+    size_t start=0;
+    while(start<=s.size()){
+        size_t comma=s.find(',',start);
+        if(comma==string::npos) comma=s.size();
+        if(comma>start) parts.push_back(s.substr(start,comma-start));
+        start=comma+1;
+    }
+    return parts;
+}
+
+bool parseArgs(int argc,char *argv[],Options &opt){
+    for(int i=1;i<argc;i++){
+        string arg=argv[i];
+        if(i+1>=argc) return false;
+        string val=argv[++i];
+        vector<string> list=splitList(val);
+        if(arg=="--sizes"){ opt.sizes.clear(); for(auto &x:list) opt.sizes.push_back(atoll(x.c_str())); }
+        else if(arg=="--loads"){ opt.loads.clear(); for(auto &x:list) opt.loads.push_back(atof(x.c_str())); }
+        else if(arg=="--keylens"){ opt.keyLengths.clear(); for(auto &x:list) opt.keyLengths.push_back(atoi(x.c_str())); }
+        else if(arg=="--hashes") opt.hashes=list;
+        else if(arg=="--tables") opt.tables=list;
+        else if(arg=="--reps") opt.reps=atoi(val.c_str());
+        else if(arg=="--warmup") opt.warmup=atoi(val.c_str());
+        else if(arg=="--seed") opt.seed=atoi(val.c_str());
+        else if(arg=="--label") opt.label=val;
+        else if(arg=="--csv") opt.csvPath=val;
+        else if(arg=="--json") opt.jsonPath=val;
+        else return false;
+    }
+    for(auto &t:opt.tables)
+        if(t!="B.chaining"&&t!="B.double"&&t!="B.custom"&&t!="B.group"&&t!="B.robin"&&t!="B.cuckoo"&&
+           t!="C.chaining"&&t!="C.double"&&t!="C.custom") return false;
+    for(auto &h:opt.hashes)
+        if(h!="poly"&&h!="djb2"&&h!="wyhash") return false;
+    for(double l:opt.loads) if(l<=0||l>=1) return false;
+    for(long long s:opt.sizes) if(s<1) return false;
+    for(int l:opt.keyLengths) if(l<1) return false;
+    return opt.reps>=1&&opt.warmup>=0;
+}
+
+int main(int argc,char *argv[]){
+    Options opt;
+    if(!parseArgs(argc,argv,opt)){
+        cerr<<"usage: "<<argv[0]<<" [--sizes N,...] [--loads F,...] [--keylens L,...]"
+              " [--hashes poly,djb2,wyhash] [--tables B.chaining,...,C.custom]"
+              " [--reps R] [--warmup W] [--seed S] [--label L] [--csv F] [--json F]\n";
+        return 1;
+    }
+
+    cout<<left<<setw(12)<<"table"<<setw(8)<<"hash"<<right<<setw(11)<<"keys"<<setw(7)<<"load"
+        <<setw(7)<<"actual"<<setw(5)<<"len"<<"  "<<left<<setw(12)<<"operation"<<right
+        <<setw(10)<<"ns/op"<<setw(10)<<"95% CI"<<setw(9)<<"Mops/s"<<"\n";
+
+    vector<Result> results;
+    mt19937 rng(opt.seed);
+    for(long long n:opt.sizes)
+        for(int len:opt.keyLengths){
+            Keys k=makeKeys(n,len,rng);
+            for(double load:opt.loads)
+                for(auto &table:opt.tables)
+                    for(auto &hash:opt.hashes){
+                        Result proto{table,hash,n,load,0,len,INSERT,{},0};
+                        runConfig(opt,k,table,hash,load,proto,results);
+                    }
+        }
+
+    if(!opt.csvPath.empty()) writeCsv(opt.csvPath,opt,results);
+    if(!opt.jsonPath.empty()) writeJson(opt.jsonPath,opt,results);
+    return 0;
+}
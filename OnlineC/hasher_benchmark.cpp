@@ -0,0 +1,98 @@
+#include "HashTables.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+using namespace std;
+using namespace onlinec;
+
+// Cost of calling the hash function through std::function (the old
+// insert/search signature) versus a hasher type fixed at compile time.
+// Usage: ./hasher_benchmark [numWords]   (default: 1000000)
+
+typedef function<size_t(const string&)> DynamicHasher;
+
+double nsPerOp(chrono::steady_clock::time_point start,int ops){
+    auto elapsed=chrono::steady_clock::now()-start;
+    return chrono::duration<double,nano>(elapsed).count()/ops;
+}
+
+template<typename Table>
+void benchmark(const string &name,Table &table,const vector<string> &words){
+    int n=words.size();
+    auto start=chrono::steady_clock::now();
+    for(int i=0;i<n;i++) table.insert(words[i],i);
+    double insertNs=nsPerOp(start,n);
+
+    long long hits=0;
+    int tempHits;
+    start=chrono::steady_clock::now();
+    for(int i=0;i<n;i++){ table.search(words[i],tempHits); hits+=tempHits; }
+    double searchNs=nsPerOp(start,n);
+
+    cout<<left<<setw(28)<<name<<right<<fixed<<setprecision(1)
+        <<setw(12)<<insertNs<<setw(12)<<searchNs<<"   ("<<hits<<" hits)\n";
+}
+
+// Only the hash call, on a small cache-resident key set, so the indirect call
+// is not hidden behind cache misses on the table
+template<typename Hasher>
+double hashNs(const Hasher &hashFunc,const vector<string> &words,int rounds){
+    size_t sink=0;
+    auto start=chrono::steady_clock::now();
+    for(int r=0;r<rounds;r++)
+        for(auto &w:words) sink+=hashFunc(w)%1000003;
+    double ns=nsPerOp(start,rounds*(int)words.size());
+    if(sink==1) cout<<"";
+    return ns;
+}
+
+int main(int argc,char *argv[]){
+    int n=(argc>1)?atoi(argv[1]):1000000;
+    int C1=1,C2=3;
+
+    mt19937 rng(42);
+    vector<string> words(n);
+    for(auto &w:words) w=generateWord(10,rng);
+
+    DynamicHasher dynamicDjb2=[](const string &s){ return djb2Hash(s); };
+
+    vector<string> hot(words.begin(),words.begin()+min(n,4096));
+    cout<<fixed<<setprecision(2)
+        <<"Hash call only: template "<<hashNs(Djb2Hasher(),hot,200)
+        <<" ns, std::function "<<hashNs(dynamicDjb2,hot,200)
+        <<" ns, wyhash "<<hashNs(WyHasher(),hot,200)<<" ns\n\n";
+
+    cout<<left<<setw(28)<<"Table / hasher"<<right<<setw(12)<<"insert ns"<<setw(12)<<"search ns\n";
+    {
+        HashTableChaining<string,int,Djb2Hasher> t;
+        benchmark("Chaining template",t,words);
+    }
+    {
+        HashTableChaining<string,int,DynamicHasher> t(INITIAL_SIZE,dynamicDjb2);
+        benchmark("Chaining std::function",t,words);
+    }
+    {
+        HashTableChaining<string,int,WyHasher> t;
+        benchmark("Chaining wyhash",t,words);
+    }
+    {
+        HashTableDouble<string,int,Djb2Hasher> t;
+        benchmark("Double template",t,words);
+    }
+    {
+        HashTableDouble<string,int,DynamicHasher> t(INITIAL_SIZE,dynamicDjb2);
+        benchmark("Double std::function",t,words);
+    }
+    {
+        HashTableCustom<string,int,Djb2Hasher> t(C1,C2);
+        benchmark("Custom template",t,words);
+    }
+    {
+        HashTableCustom<string,int,DynamicHasher> t(C1,C2,INITIAL_SIZE,dynamicDjb2);
+        benchmark("Custom std::function",t,words);
+    }
+    return 0;
+}
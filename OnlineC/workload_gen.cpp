@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+#include "../OnlineB/HashTable.h"
+#include "../OnlineB/Workload.h"
+#include "HashTables.h"
+using namespace std;
+
+// Writes a key workload file (see Workload.h) for the drivers to stream.
+//
+// Usage: ./workload_gen --out FILE --count N [--dist uniform|zipf|sequential|adversarial]
+//          [--len L | --len-min A --len-max B [--len-dist uniform|normal]]
+//          [--seed S] [--threads T] [--universe U] [--zipf S]
+//          [--adversary HASH --buckets M [--target B]] [--print K]
+// HASH names the bucket function being attacked:
+//   b-poly, b-djb2, b-wyhash  OnlineB HashTable, hash type 1 / 2 / WyHash
+//                             (the 32-bit half that picks the home slot)
+//   c-poly, c-djb2, c-wyhash  OnlineC tables (hash % size)
+// --print K prints the first K keys of the written file.
+
+function<uint64_t(const string&)> adversaryHash(const string &name){
+    if(name=="b-poly") return [](const string &k){ return KeyHash<string>()(k)>>32; };
+    if(name=="b-djb2") return [](const string &k){ return KeyHash<string>()(k)&0xFFFFFFFFULL; };
+    if(name=="b-wyhash") return [](const string &k){ return WyHash()(k)>>32; };
+    if(name=="c-poly") return [](const string &k){ return (uint64_t)onlinec::PolyHasher()(k); };
+    if(name=="c-djb2") return [](const string &k){ return (uint64_t)onlinec::Djb2Hasher()(k); };
+    if(name=="c-wyhash") return [](const string &k){ return (uint64_t)onlinec::WyHasher()(k); };
+    return nullptr;
+}
+
+int main(int argc,char *argv[]){
+    WorkloadSpec spec;
+    string out,adversary;
+    long long printCount=0;
+    bool ok=true;
+    for(int i=1;i<argc&&ok;i+=2){
+        string arg=argv[i];
+        if(i+1>=argc){ ok=false; break; }
+        string val=argv[i+1];
+        if(arg=="--out") out=val;
+        else if(arg=="--count") spec.count=atoll(val.c_str());
+        else if(arg=="--dist"){
+            if(val=="uniform") spec.distribution=UNIFORM_KEYS;
+            else if(val=="zipf") spec.distribution=ZIPF_KEYS;
+            else if(val=="sequential") spec.distribution=SEQUENTIAL_KEYS;
+            else if(val=="adversarial") spec.distribution=ADVERSARIAL_KEYS;
+            else ok=false;
+        }
+        else if(arg=="--len") spec.minLength=spec.maxLength=atoi(val.c_str());
+        else if(arg=="--len-min") spec.minLength=atoi(val.c_str());
+        else if(arg=="--len-max") spec.maxLength=atoi(val.c_str());
+        else if(arg=="--len-dist"){
+            if(val=="fixed") spec.lengths=FIXED_LENGTH;
+            else if(val=="uniform") spec.lengths=UNIFORM_LENGTH;
+            else if(val=="normal") spec.lengths=NORMAL_LENGTH;
+            else ok=false;
+        }
+        else if(arg=="--seed") spec.seed=strtoull(val.c_str(),nullptr,10);
+        else if(arg=="--threads") spec.threads=atoi(val.c_str());
+        else if(arg=="--universe") spec.universe=atoll(val.c_str());
+        else if(arg=="--zipf") spec.zipfExponent=atof(val.c_str());
+        else if(arg=="--adversary") adversary=val;
+        else if(arg=="--buckets") spec.buckets=atoll(val.c_str());
+        else if(arg=="--target") spec.targetBucket=atoll(val.c_str());
+        else if(arg=="--print") printCount=atoll(val.c_str());
+        else ok=false;
+    }
+    if(!adversary.empty()&&!(spec.bucketHash=adversaryHash(adversary))) ok=false;
+    if(!ok||out.empty()||spec.count==0){
+        cerr<<"usage: "<<argv[0]<<" --out FILE --count N [--dist uniform|zipf|sequential|adversarial]"
+              " [--len L | --len-min A --len-max B --len-dist fixed|uniform|normal]"
+              " [--seed S] [--threads T] [--universe U] [--zipf S]"
+              " [--adversary b-poly|b-djb2|b-wyhash|c-poly|c-djb2|c-wyhash --buckets M [--target B]]"
+              " [--print K]\n";
+        return 1;
+    }
+
+    try{
+        auto start=chrono::steady_clock::now();
+        writeWorkload(out,spec);
+        double seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+        WorkloadReader reader(out);
+        const WorkloadHeader &h=reader.getHeader();
+        cout<<out<<": "<<h.count<<" keys ("<<h.universe<<" distinct, "<<h.keyBytes
+            <<" key bytes) in "<<seconds<<" s, "<<h.count/seconds/1e6<<" M keys/s\n";
+        string key;
+        for(long long i=0;i<printCount&&reader.next(key);i++) cout<<key<<"\n";
+    }catch(const exception &e){
+        cerr<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 /* CPP program to print all distinct elements
    of a given array */
 #include <bits/stdc++.h>
+#include "OnlineB/HyperLogLog.h"
 using namespace std;
 
 // This function prints all distinct elements
@@ -24,6 +25,26 @@ int countDistinct(int arr[], int n)
     return res;
 }
 
+// Same count in a few KiB however large the input:
+// a HyperLogLog estimate, exact for small inputs
+long long countDistinctApprox(int arr[], int n)
+{
+    DistinctCounter<int> counter(DISTINCT_APPROXIMATE);
+    for (int i = 0; i < n; i++)
+        counter.add(arr[i]);
+    return counter.count();
+}
+
+// Exact count over the project's HashTable, to
+// check the estimate against
+long long countDistinctExact(int arr[], int n)
+{
+    DistinctCounter<int> counter(DISTINCT_EXACT);
+    for (int i = 0; i < n; i++)
+        counter.add(arr[i]);
+    return counter.count();
+}
+
 // Driver Code
 int main()
 {
@@ -31,4 +52,4 @@ int main()
     int n = sizeof(arr) / sizeof(arr[0]);
     cout << countDistinct(arr, n);
     return 0;
-}
\ No newline at end of file
+}
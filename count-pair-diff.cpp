@@ -5,24 +5,27 @@
 #include <vector>
 #include <algorithm>
 #include <unordered_map>
+#include "OnlineB/FrequencyMap.h"
 using namespace std;
 
-int countPairs(vector<int> &arr, int k) {
+long long countPairs(vector<int> &arr, int k) {
     int n = arr.size();  
     unordered_map<int, int> freq;
-    int cnt = 0;
+    long long cnt = 0;
 
     for (int i = 0; i < n; i++) {
       
         // Check if the complement (arr[i] + k)
         // exists in the map. If yes, increment count
-        if (freq.find(arr[i] + k) != freq.end()) 
-            cnt += freq[arr[i] + k]; 
+        auto it = freq.find(arr[i] + k);
+        if (it != freq.end()) 
+            cnt += it->second; 
       
         // Check if the complement (arr[i] - k)
         // exists in the map. If yes, increment count
-        if (freq.find(arr[i] - k) != freq.end()) 
-            cnt += freq[arr[i] - k]; 
+        it = freq.find(arr[i] - k);
+        if (it != freq.end()) 
+            cnt += it->second; 
       
         // Increment the frequency of arr[i]
         freq[arr[i]]++; 
@@ -30,6 +33,16 @@ int countPairs(vector<int> &arr, int k) {
     return cnt;
 }
 
+// Same counts for many k at once: the frequencies are
+// built once, in cache-sized partitions on all threads,
+// and every k is answered in one pass over them
+vector<long long> countPairs(vector<int> &arr, vector<int> &ks) {
+    FrequencyMap<int> freq(arr);
+    vector<long long> diffs(ks.begin(), ks.end());
+    vector<uint64_t> counts = freq.countPairs(diffs);
+    return vector<long long>(counts.begin(), counts.end());
+}
+
 int main() {
     vector<int> arr = {1, 4, 1, 4, 5};
     int k = 3;
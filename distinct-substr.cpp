@@ -1,53 +1,24 @@
 #include<iostream>
-#include<vector>
+#include<string>
+#include "OnlineB/SuffixArray.h"
 using namespace std;
 
-class TrieNode {
-public:
-    bool isWord;
-    TrieNode* child[26];
-
-    TrieNode()
-    {
-        isWord = 0;
-        for (int i = 0; i < 26; i++) {
-            child[i] = 0;
-        }
-    }
-};
-
-int countSubs(string &s)
+// Number of distinct non-empty substrings of s, any bytes.
+// Every suffix contributes its length, less the prefix it
+// shares with the suffix just before it in sorted order:
+// a suffix array (SA-IS) and its LCP array (Kasai), both
+// linear, where a trie of all suffixes takes O(n^2) nodes.
+long long countSubs(string &s)
 {
-    TrieNode* head = new TrieNode();
-
-    // will hold the count of unique substrings 
-    int count = 0;
-
-    for (int i = 0; i < s.length(); i++) {
-        TrieNode* temp = head;
-
-        for (int j = i; j < s.length(); j++) {
-            
-            // when char not present add it to the trie
-            if (temp->child[s[j] - 'a'] == NULL) {
-                temp->child[s[j] - 'a'] = new TrieNode();
-                temp->isWord = 1;
-                count++;
-            }
-            // move on to the next char
-            temp = temp->child[s[j] - 'a'];
-        }
-    }
-
-    return count;
+    return countDistinctSubstrings(s);
 }
 
 int main()
 {
     string s="abcd";
-    int count = countSubs(s);
+    long long count = countSubs(s);
 
     cout << count<< endl;
 
     return 0;
-}
\ No newline at end of file
+}